@@ -0,0 +1,423 @@
+// Resident analysis server: keeps parsed sessions, calibration tables and speed series
+// in memory and answers queries on a local socket, so an interactive question does not
+// pay for a cold start (folder scans, CSV parsing, calibration loading) every time.
+// Sessions are held with their event anchors, time index and window prefix sums
+// (windowprefix.h) in an LRU cache bounded by --cache; calibration tables and speed
+// series have caches of their own. Every entry is checked against its files' size and
+// mtime on use and rebuilt when they changed (sessionstore.h).
+//
+// The protocol is one request per line on a Unix domain socket; each response ends
+// with a line holding a single ".". Requests:
+//   pupil shook|noshook <index,...|all> [before <offset> <length>] [after <offset> <length>]
+//       window stats of the sessions, columns as in windowsweep's sweep.tsv; the
+//       windows default to the condition's own (5 s before "0.2 seconds", 5 s after
+//       "shook" or 0.229 s after "0.2 seconds")
+//   ttest [alpha,...] [before|after|both] [welch]
+//       the ttestbatch table and summary for the pupil rows of every shook and noshook
+//       session (noshook rows replace shook ones of the same index, as in pipeline)
+//   cc <index> [maxLag]
+//       the CC(t) curve of the index's player and robot speeds over its intermediate/
+//       sessions, as speed then crosscorrelation compute it (the speeds in full
+//       precision); maxLag defaults to a quarter of the series
+//   stats          cache sizes and hit counts
+//   quit           close this connection
+//   shutdown       stop the server
+// e.g. echo "pupil shook all after 0 2" | socat - UNIX-CONNECT:analysisd.sock
+// --preload loads every shook and noshook session at start.
+//g++ -std=c++17 -O2 analysisd.cpp -o analysisd -pthread
+//usage: ./analysisd [--socket analysisd.sock] [--cache 256] [--preload] [-j threads]
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "windowprefix.h"
+#include "ttestengine.h"
+#include "crosscorr.h"
+#include "speedkernel.h"
+#include "sessionstore.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+// A session with everything a window query needs
+struct CachedSession {
+    CachedSession(const fs::path& csv, const Condition& cond) : session(csv, cond), problem(session.problem()) {
+        if (!problem.empty()) return;
+        prefix = make_unique<WindowPrefix>(session);
+        averages = pupilAverages(session);
+    }
+    WindowSession session;
+    string problem;                       // why it cannot be analysed, empty when it can
+    unique_ptr<WindowPrefix> prefix;
+    vector<double> averages;              // pupilAverages() of the condition's windows
+};
+
+struct SpeedSeries {
+    vector<double> player, robot;
+};
+
+const SessionField kPositionFields[6] = {COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ};
+
+class AnalysisServer {
+public:
+    AnalysisServer(size_t capacity, int threads)
+        : sessions_(capacity), mappings_(capacity), speeds_(capacity), threads_(threads) {}
+
+    // Response to one request line, without the terminating "."
+    string handle(const string& line) {
+        istringstream in(line);
+        string cmd;
+        in >> cmd;
+        try {
+            if (cmd == "pupil") return pupil(in);
+            if (cmd == "ttest") return ttest(in);
+            if (cmd == "cc") return cc(in);
+            if (cmd == "stats") return stats();
+        } catch (const exception& e) {
+            return string("error: ") + e.what() + "\n";
+        }
+        return "error: unknown request '" + cmd + "' (pupil, ttest, cc, stats, quit, shutdown)\n";
+    }
+
+    // Sessions of cond, index order; only the wanted indices unless wanted is empty
+    vector<shared_ptr<const CachedSession>> load(const Condition& cond, const set<string>& wanted = {}) {
+        vector<fs::path> files;
+        for (const fs::path& csv : listing_.files(cond.name, ".csv"))
+            if (wanted.empty() || wanted.count(csv.filename().string().substr(0, 5))) files.push_back(csv);
+        return parallelMap<shared_ptr<const CachedSession>>(files.size(), threads_, [&](size_t k) {
+            string key = string(cond.name) + '\n' + files[k].string();
+            return sessions_.get(key, Manifest::signature({files[k]}), [&] {
+                return make_shared<const CachedSession>(files[k], cond);
+            });
+        });
+    }
+
+private:
+    static const Condition& condition(const string& name) {
+        if (name == "shook") return kShook;
+        if (name == "noshook") return kNoshook;
+        throw runtime_error("unknown condition '" + name + "' (shook, noshook)");
+    }
+
+    string pupil(istringstream& in) {
+        string condName, list, side;
+        in >> condName >> list;
+        const Condition& cond = condition(condName);
+        if (list.empty()) throw runtime_error("usage: pupil shook|noshook <index,...|all> [before|after offset length]");
+        // Offsets relative to the condition's anchors, as windowsweep takes them
+        double offset[2] = {cond.before.offset, cond.after.offset};
+        double length[2] = {cond.before.to - cond.before.from, cond.after.to - cond.after.from};
+        while (in >> side) {
+            int k = side == "before" ? 0 : side == "after" ? 1 : -1;
+            if (k < 0 || !(in >> offset[k] >> length[k]) || !(length[k] > 0))
+                throw runtime_error("expected 'before|after <offset> <length>' with a positive length");
+        }
+        set<string> wanted;
+        if (list != "all") {
+            stringstream ss(list);
+            string item;
+            while (getline(ss, item, ','))
+                if (!item.empty()) wanted.insert(item);
+        }
+        ostringstream out;
+        out << "condition\tindex\tside\toffset\tlength\trows\tluminance\tleftPupil\tleftN\tleftSd\trightPupil\trightN\trightSd\n";
+        set<string> seen;
+        for (const auto& s : load(cond, wanted)) {
+            seen.insert(s->session.fileIndex);
+            if (!s->problem.empty()) {
+                out << "# " << s->session.fileIndex << ": " << s->problem << '\n';
+                continue;
+            }
+            for (int k = 0; k < 2; k++) {
+                WindowStats w = windowStats(s->session, *s->prefix, k == 1, offset[k], length[k]);
+                out << cond.name << '\t' << s->session.fileIndex << '\t' << (k ? "after" : "before") << '\t'
+                    << offset[k] << '\t' << length[k] << '\t' << w.rows << '\t' << w.luminance;
+                for (int eye = 0; eye < 2; eye++) out << '\t' << w.pupil[eye] << '\t' << w.n[eye] << '\t' << w.sd[eye];
+                out << '\n';
+            }
+        }
+        for (const string& index : wanted)
+            if (!seen.count(index)) out << "# " << index << ": no session in " << cond.name << "/\n";
+        return out.str();
+    }
+
+    string ttest(istringstream& in) {
+        vector<double> alphas = {0.05};
+        vector<PupilHalf> halves = {BEFORE_EVENT, AFTER_EVENT};
+        bool welch = false;
+        string arg;
+        while (in >> arg) {
+            if (arg == "welch") welch = true;
+            else if (arg == "before") halves = {BEFORE_EVENT};
+            else if (arg == "after") halves = {AFTER_EVENT};
+            else if (arg == "both") halves = {BEFORE_EVENT, AFTER_EVENT};
+            else alphas = parseAlphas(arg);
+        }
+        // The pupil rows pipeline hands its t-test stage, from the cached sessions
+        WindowRun run;
+        for (const Condition* cond : {&kShook, &kNoshook})
+            for (const auto& s : load(*cond)) {
+                SessionResult res;
+                res.fileIndex = s->session.fileIndex;
+                res.averages = s->averages;
+                run.results.push_back(move(res));
+            }
+        vector<PupilRow> rows[2];
+        collectPupilRows(run, rows);
+        if (rows[0].empty() || rows[1].empty()) return "error: no valid pupil rows for one or both eyes\n";
+        vector<string> indices = pupilIndices(rows[0], rows[1]);
+        vector<shared_ptr<const CalibrationTable>> tables =
+            parallelMap<shared_ptr<const CalibrationTable>>(indices.size(), threads_, [&](size_t k) {
+                fs::path path = fs::path("output_mappings") / (indices[k] + "_luminance_mapping.txt");
+                return mappings_.get(path.string(), Manifest::signature({path}), [&] {
+                    return make_shared<const CalibrationTable>(path.string());
+                });
+            });
+        vector<const CalibrationTable*> mappings;
+        for (const auto& t : tables) mappings.push_back(t.get());
+        TestBatch batch = runTTests(indices, rows[0], rows[1], mappings, halves, welch);
+        ostringstream out;
+        writeTestTable(out, batch, alphas);
+        printTestSummary(out, batch, halves, alphas, welch);
+        return out.str();
+    }
+
+    string cc(istringstream& in) {
+        string index, lag;
+        in >> index >> lag;
+        if (index.empty()) throw runtime_error("usage: cc <index> [maxLag]");
+        int maxLag = -1;
+        if (!lag.empty()) {
+            char* end;
+            long v = strtol(lag.c_str(), &end, 10);
+            if (*end || v < 0) throw runtime_error("maxLag must be a whole number >= 0, got '" + lag + "'");
+            maxLag = min<long>(v, INT_MAX);
+        }
+        vector<fs::path> files;
+        for (const fs::path& csv : listing_.files("intermediate", ".csv"))
+            if (csv.filename().string().substr(0, 5) == index) files.push_back(csv);
+        if (files.empty()) return "error: no intermediate/ session for index " + index + "\n";
+        shared_ptr<const SpeedSeries> s = speeds_.get(index, Manifest::signature(files), [&] {
+            return make_shared<const SpeedSeries>(speedSeries(files));
+        });
+        if (s->player.size() < 2)
+            return "error: insufficient speed data for index " + index + ": " + to_string(s->player.size()) + " valid rows\n";
+        if (maxLag < 0) maxLag = s->player.size() / 4;
+        maxLag = min<int>(maxLag, s->player.size() - 1);
+        vector<double> curve = crossCorrelation(s->player, s->robot, maxLag);
+        int bestLag = -maxLag;
+        for (int t = -maxLag; t <= maxLag; t++)
+            if (curve[t + maxLag] > curve[bestLag + maxLag]) bestLag = t;
+        ostringstream out;
+        out << "# index " << index << ": " << s->player.size() << " frames, best lag " << bestLag << ", CC "
+            << curve[bestLag + maxLag] << "\nlag\tCC\n";
+        for (int t = -maxLag; t <= maxLag; t++) out << t << '\t' << curve[t + maxLag] << '\n';
+        return out.str();
+    }
+
+    // Speeds of the sessions in file order, with the -1 frames dropped, as the speed
+    // file of the index reads into crosscorrelation
+    static SpeedSeries speedSeries(const vector<fs::path>& files) {
+        SpeedSeries s;
+        for (const fs::path& path : files) {
+            SessionColumns data(path.string());
+            if (data.empty()) continue;
+            const double* pos[6];
+            bool valid = true;
+            for (int k = 0; k < 6; k++) {
+                valid = valid && data.column(kPositionFields[k]) >= 0;
+                pos[k] = data.values(kPositionFields[k]);
+            }
+            if (!valid) continue;
+            vector<double> player(data.rows()), robot(data.rows());
+            frameSpeeds(pos, data.rows(), player.data(), robot.data());
+            for (size_t i = 0; i < data.rows(); i++) {
+                if (player[i] < 0) continue;
+                s.player.push_back(player[i]);
+                s.robot.push_back(robot[i]);
+            }
+        }
+        return s;
+    }
+
+    string stats() const {
+        ostringstream out;
+        auto line = [&](const char* name, auto& c) {
+            out << name << '\t' << c.size() << " / " << c.capacity() << " cached\t" << c.hits() << " hits\t"
+                << c.misses() << " loads\n";
+        };
+        line("sessions", sessions_);
+        line("mappings", mappings_);
+        line("speeds", speeds_);
+        return out.str();
+    }
+
+    LruCache<CachedSession> sessions_;
+    LruCache<CalibrationTable> mappings_;
+    LruCache<SpeedSeries> speeds_;
+    FolderListing listing_;
+    int threads_;
+};
+
+string socketPath = "analysisd.sock";
+atomic<int> listenFd{-1};
+atomic<bool> stopping{false};
+
+void stopServer(int) {
+    stopping = true;
+    shutdown(listenFd, SHUT_RDWR);
+}
+
+bool writeAll(int fd, const string& data) {
+    for (size_t done = 0; done < data.size();) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+// Serve one client until it quits or disconnects
+void serveClient(int fd, AnalysisServer& server) {
+    string buf;
+    char chunk[4096];
+    while (!stopping) {
+        size_t nl;
+        while ((nl = buf.find('\n')) == string::npos) {
+            ssize_t n = read(fd, chunk, sizeof chunk);
+            if (n <= 0) return;
+            buf.append(chunk, n);
+        }
+        string line = buf.substr(0, nl);
+        buf.erase(0, nl + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find_first_not_of(" \t") == string::npos) continue;
+        if (line == "quit") break;
+        if (line == "shutdown") {
+            writeAll(fd, "stopping\n.\n");
+            stopServer(0);
+            break;
+        }
+        if (!writeAll(fd, server.handle(line) + ".\n")) break;
+    }
+}
+
+// The client threads, so main can end their connections and join them before the
+// server they use goes away. A socket is closed under the lock when its thread is done,
+// so stop() never shuts down a descriptor that has been reused since.
+class ClientThreads {
+public:
+    void start(int fd, AnalysisServer& server) {
+        lock_guard<mutex> lock(m_);
+        reap();
+        clients_.emplace_back();
+        Client& c = clients_.back();
+        c.fd = fd;
+        c.t = thread([this, &c, &server] {
+            serveClient(c.fd, server);
+            lock_guard<mutex> lock(m_);
+            close(c.fd);
+            c.done = true;
+        });
+    }
+
+    // Wake every open connection and wait for its thread
+    void stop() {
+        {
+            lock_guard<mutex> lock(m_);
+            for (Client& c : clients_)
+                if (!c.done) shutdown(c.fd, SHUT_RDWR);
+        }
+        for (Client& c : clients_) c.t.join();
+        clients_.clear();
+    }
+
+private:
+    struct Client {
+        thread t;
+        int fd = -1;
+        bool done = false;
+    };
+
+    // Join the threads that have finished (called with m_ held)
+    void reap() {
+        for (auto it = clients_.begin(); it != clients_.end();)
+            if (it->done) {
+                it->t.join();
+                it = clients_.erase(it);
+            } else {
+                ++it;
+            }
+    }
+
+    mutex m_;
+    list<Client> clients_;
+};
+
+int main(int argc, char** argv) {
+    size_t capacity = 256;
+    bool preload = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--cache" && i + 1 < argc) capacity = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--preload") preload = true;
+    }
+    if (capacity == 0) {
+        cerr << "Error: --cache must be a positive number of entries" << endl;
+        return 1;
+    }
+    int threads = parseThreads(argc, argv);
+    AnalysisServer server(capacity, threads);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "Error: socket path too long: " << socketPath << endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof addr) != 0 || listen(fd, 16) != 0) {
+        cerr << "Error: Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    listenFd = fd;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+
+    if (preload) {
+        size_t n = 0;
+        for (const Condition* cond : {&kShook, &kNoshook}) n += server.load(*cond).size();
+        cerr << "Preloaded " << n << " sessions" << endl;
+    }
+    cerr << "Listening on " << socketPath << endl;
+    ClientThreads clients;
+    while (!stopping) {
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        clients.start(client, server);
+    }
+    close(fd);
+    clients.stop();
+    unlink(socketPath.c_str());
+    cerr << "Stopped" << endl;
+    return 0;
+}
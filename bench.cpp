@@ -0,0 +1,164 @@
+// Google Benchmark targets for the hot paths of the C++ tools, run on synthetic
+// sessions (synthetic.h) written to a temporary folder, so the numbers can be compared
+// between machines and commits without participant data:
+//   CSVFile parse, SessionColumns build (cold) and sidecar load (warm), the pupil
+//   window averages, calibration lookups, the speed kernel, the event locator and the
+//   stats accumulator.
+// Row counts are the benchmark argument; counters report rows and bytes per second.
+//g++ -std=c++17 -O2 bench.cpp -o bench -pthread -lbenchmark
+//usage: ./bench [--benchmark_filter=regex] [--benchmark_format=json] [--benchmark_out=file]
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "synthetic.h"
+#include "windowengine.h"
+#include "calibrationtable.h"
+#include "speedkernel.h"
+#include "eventlocator.h"
+#include "stats.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+static fs::path benchFolder() {
+    static fs::path folder = fs::temp_directory_path() / ("fire2bench-" + to_string(getpid()));
+    return folder;
+}
+
+// Synthetic shook session of `rows` rows, written once per row count
+static string sessionFile(size_t rows) {
+    static map<size_t, string> files;
+    auto it = files.find(rows);
+    if (it != files.end()) return it->second;
+    fs::path dir = benchFolder() / "shook";
+    fs::create_directories(dir);
+    string path = (dir / (to_string(10001 + files.size()) + "_Standard_Office.csv")).string();
+    writeTextFile(path, syntheticSessionCSV(rows, 1, rows, true));
+    return files[rows] = path;
+}
+
+static void setRates(benchmark::State& state, size_t rows, size_t bytes) {
+    state.counters["rows/s"] = benchmark::Counter(double(rows) * state.iterations(), benchmark::Counter::kIsRate);
+    if (bytes) state.SetBytesProcessed(int64_t(bytes) * state.iterations());
+}
+
+static void BM_CSVFileParse(benchmark::State& state) {
+    string path = sessionFile(state.range(0));
+    size_t bytes = fs::file_size(path);
+    for (auto _ : state) {
+        CSVFile csv(path);
+        benchmark::DoNotOptimize(csv.size());
+    }
+    setRates(state, state.range(0), bytes);
+}
+BENCHMARK(BM_CSVFileParse)->RangeMultiplier(10)->Range(1000, 100000);
+
+// Full parse into typed columns: the sidecar is removed before every iteration
+static void BM_SessionColumnsBuild(benchmark::State& state) {
+    string path = sessionFile(state.range(0));
+    size_t bytes = fs::file_size(path);
+    for (auto _ : state) {
+        state.PauseTiming();
+        fs::remove(path + ".cols");
+        state.ResumeTiming();
+        SessionColumns data(path);
+        benchmark::DoNotOptimize(data.rows());
+    }
+    setRates(state, state.range(0), bytes);
+}
+BENCHMARK(BM_SessionColumnsBuild)->RangeMultiplier(10)->Range(1000, 100000);
+
+static void BM_SessionColumnsCached(benchmark::State& state) {
+    string path = sessionFile(state.range(0));
+    { SessionColumns warm(path); }
+    for (auto _ : state) {
+        SessionColumns data(path);
+        benchmark::DoNotOptimize(data.values(COL_TIME));
+    }
+    setRates(state, state.range(0), 0);
+}
+BENCHMARK(BM_SessionColumnsCached)->RangeMultiplier(10)->Range(1000, 100000);
+
+// Event lookup, window bounds and both 5 s windows of a cached session
+static void BM_PupilAverages(benchmark::State& state) {
+    string path = sessionFile(state.range(0));
+    { SessionColumns warm(path); }
+    for (auto _ : state) {
+        WindowSession s(path, kShook);
+        benchmark::DoNotOptimize(pupilAverages(s));
+    }
+    setRates(state, state.range(0), 0);
+}
+BENCHMARK(BM_PupilAverages)->RangeMultiplier(10)->Range(1000, 100000);
+
+static void BM_CalibrationLookup(benchmark::State& state) {
+    fs::path mapping = benchFolder() / "10001_luminance_mapping.txt";
+    writeTextFile(mapping, syntheticMapping(1, 0));
+    CalibrationTable table(mapping.string());
+    CounterRng rng(1, 1);
+    vector<double> lums(state.range(0));
+    for (double& l : lums) l = rng.uniform();
+    vector<double> out;
+    auto mode = CalibrationTable::Lookup(state.range(1));
+    for (auto _ : state) {
+        out.clear();
+        table.expected(CalibrationTable::LEFT, lums, out, mode);
+        benchmark::DoNotOptimize(out.data());
+    }
+    setRates(state, lums.size(), 0);
+}
+BENCHMARK(BM_CalibrationLookup)->ArgsProduct({{100000}, {CalibrationTable::NEAREST, CalibrationTable::LINEAR}});
+
+static void BM_FrameSpeeds(benchmark::State& state) {
+    size_t n = state.range(0);
+    CounterRng rng(1, 2);
+    vector<double> cols[6];
+    const double* pos[6];
+    for (int c = 0; c < 6; c++) {
+        cols[c].resize(n);
+        for (double& v : cols[c]) v = rng.uniform(-5, 5);
+        pos[c] = cols[c].data();
+    }
+    vector<double> player(n), robot(n);
+    for (auto _ : state) {
+        frameSpeeds(pos, n, player.data(), robot.data());
+        benchmark::DoNotOptimize(player.data());
+    }
+    setRates(state, n, 0);
+}
+BENCHMARK(BM_FrameSpeeds)->RangeMultiplier(10)->Range(1000, 100000);
+
+// Worst case for the locator: a pattern that never occurs, so the whole file is read
+static void BM_EventScan(benchmark::State& state) {
+    MappedFile file(sessionFile(state.range(0)));
+    EventPatterns patterns({"0.2 seconds", "shook", "never in a session"}, state.range(1) != 0);
+    for (auto _ : state) benchmark::DoNotOptimize(patterns.scan(file.text()));
+    setRates(state, state.range(0), file.text().size());
+}
+BENCHMARK(BM_EventScan)->ArgsProduct({{1000, 10000, 100000}, {0, 1}});
+
+static void BM_RunningStats(benchmark::State& state) {
+    CounterRng rng(1, 3);
+    vector<double> values(state.range(0));
+    for (double& v : values) v = rng.uniform(2.5, 5);
+    for (auto _ : state) {
+        RunningStats s;
+        for (double v : values) s.add(v);
+        benchmark::DoNotOptimize(s.variance());
+    }
+    setRates(state, values.size(), 0);
+}
+BENCHMARK(BM_RunningStats)->Arg(100000);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    std::error_code ec;
+    fs::remove_all(benchFolder(), ec);
+    return 0;
+}
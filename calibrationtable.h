@@ -0,0 +1,108 @@
+// Luminance -> expected pupil size calibration for one participant.
+// An <index>_luminance_mapping.txt file (header line, then
+// "luminance avgLeft countLeft sdLeft avgRight countRight sdRight" rows) is loaded once
+// into sorted columns, and every lookup is a binary search over the luminance column.
+// Lookups either snap to the nearest calibrated luminance or interpolate linearly
+// between the two rows around it. Ties and repeated luminances follow the t-test tools'
+// std::map lookup: a luminance halfway between two rows takes the upper one, and of
+// rows with the same luminance the last in the file is kept.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class CalibrationTable {
+public:
+    enum Eye { LEFT, RIGHT };
+    enum Lookup { NEAREST, LINEAR };
+
+    // One eye's calibration row
+    struct Entry {
+        double luminance;
+        double avgSize;
+        int count;
+        double stdDev;
+    };
+
+    CalibrationTable() = default;
+    // Empty table when the file is missing or has no data rows
+    explicit CalibrationTable(const std::string& path) {
+        std::ifstream inFile(path);
+        if (!inFile) return;
+        std::string line;
+        bool headerSkipped = false;
+        struct Row { double lum, avg[2], count[2], sd[2]; };
+        std::vector<Row> rows;
+        while (getline(inFile, line)) {
+            if (line.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+            if (!headerSkipped) { // Skip header
+                headerSkipped = true;
+                continue;
+            }
+            std::istringstream iss(line);
+            Row r;
+            if (iss >> r.lum >> r.avg[LEFT] >> r.count[LEFT] >> r.sd[LEFT] >> r.avg[RIGHT] >> r.count[RIGHT] >> r.sd[RIGHT])
+                rows.push_back(r);
+        }
+        // Sorted by luminance; of repeated luminances the last row wins
+        std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.lum < b.lum; });
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (i + 1 < rows.size() && rows[i + 1].lum == rows[i].lum) continue;
+            lum_.push_back(rows[i].lum);
+            for (int e = LEFT; e <= RIGHT; e++) {
+                avg_[e].push_back(rows[i].avg[e]);
+                count_[e].push_back((int)rows[i].count[e]);
+                sd_[e].push_back(rows[i].sd[e]);
+            }
+        }
+    }
+
+    bool empty() const { return lum_.empty(); }
+    size_t size() const { return lum_.size(); }
+
+    // Row with the closest luminance (the upper one on a tie); table must not be empty
+    size_t nearestRow(double lum) const {
+        size_t hi = std::lower_bound(lum_.begin(), lum_.end(), lum) - lum_.begin();
+        if (hi == lum_.size()) return hi - 1;
+        if (hi == 0) return 0;
+        return std::fabs(lum_[hi - 1] - lum) < std::fabs(lum_[hi] - lum) ? hi - 1 : hi;
+    }
+
+    Entry entry(Eye eye, size_t row) const {
+        return {lum_[row], avg_[eye][row], count_[eye][row], sd_[eye][row]};
+    }
+    Entry nearest(Eye eye, double lum) const { return entry(eye, nearestRow(lum)); }
+
+    // Average pupil size linearly interpolated between the calibrated luminances around
+    // lum, held constant beyond either end. When one of the two rows carries the -1
+    // "no data" marker the nearest row is used instead.
+    double interpolate(Eye eye, double lum) const {
+        const std::vector<double>& avg = avg_[eye];
+        size_t hi = std::upper_bound(lum_.begin(), lum_.end(), lum) - lum_.begin();
+        if (hi == 0) return avg.front();
+        if (hi == lum_.size()) return avg.back();
+        size_t lo = hi - 1;
+        if (avg[lo] == -1 || avg[hi] == -1) return avg[nearestRow(lum)];
+        double t = (lum - lum_[lo]) / (lum_[hi] - lum_[lo]);
+        return avg[lo] + t * (avg[hi] - avg[lo]);
+    }
+
+    double expected(Eye eye, double lum, Lookup mode) const {
+        return mode == LINEAR ? interpolate(eye, lum) : avg_[eye][nearestRow(lum)];
+    }
+
+    // Expected pupil size of every luminance in lums, appended to out
+    void expected(Eye eye, const std::vector<double>& lums, std::vector<double>& out, Lookup mode = NEAREST) const {
+        out.reserve(out.size() + lums.size());
+        for (double lum : lums) out.push_back(expected(eye, lum, mode));
+    }
+
+private:
+    std::vector<double> lum_;
+    std::vector<double> avg_[2], sd_[2];
+    std::vector<int> count_[2];
+};
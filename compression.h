@@ -0,0 +1,305 @@
+// Compressed session files: <name>.csv.gz and <name>.csv.zst.
+// The raw CSVs are repetitive text and shrink several times, so they can be stored and
+// moved compressed. The shared reader (csvreader.h) opens them like plain files:
+// Inflater decompresses on a worker thread into a buffer that CSVFile splits while
+// later chunks are still being inflated. The filter tools write compressed copies with
+// compressFile().
+// Support is compiled in per format, with the tool's other flags:
+//   gzip  -DFIRE2_ZLIB -lz
+//   zstd  -DFIRE2_ZSTD -lzstd
+// A tool built without a format reports such files as unreadable instead of parsing
+// compressed bytes.
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifdef FIRE2_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FIRE2_ZSTD
+#include <zstd.h>
+#endif
+
+enum Compression { NO_COMPRESSION, GZIP, ZSTD };
+inline const char* const kCompressionSuffix[] = {"", ".gz", ".zst"};
+
+inline Compression compressionOf(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    return ext == ".gz" ? GZIP : ext == ".zst" ? ZSTD : NO_COMPRESSION;
+}
+
+inline bool compressionSupported(Compression c) {
+    (void)c;   // unused when both libraries are built in
+#ifndef FIRE2_ZLIB
+    if (c == GZIP) return false;
+#endif
+#ifndef FIRE2_ZSTD
+    if (c == ZSTD) return false;
+#endif
+    return true;
+}
+
+// True when the file name ends in ext, or in ext plus a compression suffix
+// ("x.csv", "x.csv.gz" and "x.csv.zst" all match ".csv")
+inline bool matchesExtension(const std::filesystem::path& path, const std::string& ext) {
+    if (path.extension() == ext) return true;
+    return compressionOf(path) != NO_COMPRESSION && path.stem().extension() == ext;
+}
+
+// Parses "--compress gz|zst"; NO_COMPRESSION when absent. Unknown or unsupported
+// formats are reported and give false.
+inline bool parseCompressOption(int argc, char** argv, Compression& c) {
+    c = NO_COMPRESSION;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) != "--compress" || i + 1 >= argc) continue;
+        std::string f = argv[++i];
+        c = f == "gz" || f == "gzip" ? GZIP : f == "zst" || f == "zstd" ? ZSTD : NO_COMPRESSION;
+        if (c == NO_COMPRESSION) {
+            std::cerr << "Error: unknown --compress format '" << f << "' (gz, zst)" << std::endl;
+            return false;
+        }
+        if (!compressionSupported(c)) {
+            std::cerr << "Error: built without " << f << " support (see compression.h)" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Streaming decompression of an in-memory compressed file on a worker thread.
+// Output goes to a buffer of the expected size (from the gzip trailer or the zstd
+// frame header), so bytes once produced never move; consumers wait for more with
+// available(). Output beyond the expected size is collected separately and joined on
+// completion, which moves the text (data() changes) but keeps the first buffer alive.
+class Inflater {
+public:
+    Inflater(std::string_view src, Compression c, std::string name) : src_(src), kind_(c), name_(std::move(name)) {
+        cap_ = expectedSize();
+        buf_.reset(new char[cap_ ? cap_ : 1]);
+        data_ = buf_.get();
+        worker_ = std::thread([this] { run(); });
+    }
+    ~Inflater() {
+        if (worker_.joinable()) worker_.join();
+    }
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    // Blocks until at least want bytes are out or the stream has ended; returns the
+    // number of bytes available at data(), which is less than want only at the end
+    size_t available(size_t want) {
+        std::unique_lock<std::mutex> lock(m_);
+        cv_.wait(lock, [&] { return done_ || (produced_ >= want && want <= cap_); });
+        if (!done_) return std::min(produced_, cap_);
+        lock.unlock();
+        finish();
+        return size_;
+    }
+    const char* data() const { return data_; }
+    // Waits for the whole text
+    std::string_view text() {
+        size_t n = available(SIZE_MAX);
+        return std::string_view(data_, n);
+    }
+    bool failed() {
+        text();
+        return failed_;
+    }
+
+private:
+    static constexpr size_t kChunk = 1 << 18;
+
+    size_t expectedSize() const {
+        if (kind_ == GZIP && src_.size() >= 18) {
+            // ISIZE: uncompressed size mod 2^32 of the last member, little-endian
+            const unsigned char* t = reinterpret_cast<const unsigned char*>(src_.data() + src_.size() - 4);
+            size_t isize = size_t(t[0]) | size_t(t[1]) << 8 | size_t(t[2]) << 16 | size_t(t[3]) << 24;
+            return std::min(isize, src_.size() * 1032);   // deflate expands at most ~1032:1
+        }
+#ifdef FIRE2_ZSTD
+        if (kind_ == ZSTD) {
+            unsigned long long n = ZSTD_getFrameContentSize(src_.data(), src_.size());
+            if (n != ZSTD_CONTENTSIZE_UNKNOWN && n != ZSTD_CONTENTSIZE_ERROR) return n;
+        }
+#endif
+        return src_.size() * 8;
+    }
+
+    // Append out[0, n) to the output and wake the consumer
+    void emit(const char* out, size_t n) {
+        size_t inBuf = produced_ < cap_ ? std::min(n, cap_ - produced_) : 0;
+        memcpy(buf_.get() + produced_, out, inBuf);
+        if (inBuf < n) rest_.append(out + inBuf, n - inBuf);
+        std::lock_guard<std::mutex> lock(m_);
+        produced_ += n;
+        cv_.notify_all();
+    }
+
+    void run() {
+        bool ok = false;
+        std::vector<char> out(kChunk);
+#ifdef FIRE2_ZLIB
+        if (kind_ == GZIP) {
+            z_stream zs{};
+            ok = inflateInit2(&zs, 15 + 32) == Z_OK;   // gzip or zlib header
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src_.data()));
+            zs.avail_in = src_.size();
+            while (ok) {
+                zs.next_out = reinterpret_cast<Bytef*>(out.data());
+                zs.avail_out = out.size();
+                int rc = inflate(&zs, Z_NO_FLUSH);
+                emit(out.data(), out.size() - zs.avail_out);
+                if (rc == Z_STREAM_END) {
+                    if (zs.avail_in == 0) break;
+                    ok = inflateReset(&zs) == Z_OK;    // concatenated members
+                } else if (rc != Z_OK) {
+                    ok = false;
+                }
+            }
+            inflateEnd(&zs);
+        }
+#endif
+#ifdef FIRE2_ZSTD
+        if (kind_ == ZSTD) {
+            ZSTD_DStream* ds = ZSTD_createDStream();
+            ok = ds && !ZSTD_isError(ZSTD_initDStream(ds));
+            ZSTD_inBuffer in = {src_.data(), src_.size(), 0};
+            // Until the input is used up and the decoder has nothing left to flush (an
+            // output buffer it did not fill); the last frame must have ended there
+            size_t rc = 1;
+            while (ok) {
+                ZSTD_outBuffer o = {out.data(), out.size(), 0};
+                rc = ZSTD_decompressStream(ds, &o, &in);
+                if (ZSTD_isError(rc)) {
+                    ok = false;
+                    break;
+                }
+                emit(out.data(), o.pos);
+                if (in.pos == in.size && o.pos < o.size) break;
+            }
+            if (rc != 0) ok = false;   // truncated frame
+            ZSTD_freeDStream(ds);
+        }
+#endif
+        std::lock_guard<std::mutex> lock(m_);
+        failed_ = !ok;
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    void finish() {
+        std::call_once(finished_, [&] {
+            worker_.join();
+            if (failed_) std::cerr << "Error: Could not decompress " << name_ << std::endl;
+            size_ = produced_;
+            if (rest_.empty()) return;
+            joined_.reserve(produced_);
+            joined_.assign(buf_.get(), cap_);
+            joined_ += rest_;
+            data_ = joined_.data();
+        });
+    }
+
+    std::string_view src_;
+    Compression kind_;
+    std::string name_;
+    size_t cap_ = 0;
+    std::unique_ptr<char[]> buf_;
+    const char* data_ = nullptr;
+    std::string rest_, joined_;
+    size_t produced_ = 0, size_ = 0;
+    bool done_ = false, failed_ = false;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::once_flag finished_;
+    std::thread worker_;
+};
+
+// Write a compressed copy of src to dst (through a temporary name, so dst is never
+// partial). level 0 picks the format's default. False on any error.
+inline bool compressFile(const std::filesystem::path& src, const std::filesystem::path& dst, Compression c,
+                         int level = 0) {
+    if (c == NO_COMPRESSION || !compressionSupported(c)) return false;
+    (void)level;   // unused when no format is built in
+    std::ifstream in(src, std::ios::binary);
+    std::string tmp = dst.string() + ".tmp";
+    std::ofstream out(tmp, std::ios::binary);
+    if (!in || !out) return false;
+    std::vector<char> inBuf(1 << 18), outBuf(1 << 18);
+    bool ok = false;
+#ifdef FIRE2_ZLIB
+    if (c == GZIP) {
+        z_stream zs{};
+        ok = deflateInit2(&zs, level ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) == Z_OK;
+        bool end = false;
+        while (ok && !end) {
+            in.read(inBuf.data(), inBuf.size());
+            zs.next_in = reinterpret_cast<Bytef*>(inBuf.data());
+            zs.avail_in = in.gcount();
+            end = !in;
+            do {
+                zs.next_out = reinterpret_cast<Bytef*>(outBuf.data());
+                zs.avail_out = outBuf.size();
+                ok = deflate(&zs, end ? Z_FINISH : Z_NO_FLUSH) != Z_STREAM_ERROR;
+                out.write(outBuf.data(), outBuf.size() - zs.avail_out);
+            } while (ok && zs.avail_out == 0);
+        }
+        deflateEnd(&zs);
+    }
+#endif
+#ifdef FIRE2_ZSTD
+    if (c == ZSTD) {
+        ZSTD_CCtx* cx = ZSTD_createCCtx();
+        ok = cx && !ZSTD_isError(ZSTD_CCtx_setParameter(cx, ZSTD_c_compressionLevel, level ? level : 3));
+        bool end = false;
+        while (ok && !end) {
+            in.read(inBuf.data(), inBuf.size());
+            ZSTD_inBuffer zin = {inBuf.data(), size_t(in.gcount()), 0};
+            end = !in;
+            size_t left;
+            do {
+                ZSTD_outBuffer zout = {outBuf.data(), outBuf.size(), 0};
+                left = ZSTD_compressStream2(cx, &zout, &zin, end ? ZSTD_e_end : ZSTD_e_continue);
+                ok = !ZSTD_isError(left);
+                out.write(outBuf.data(), zout.pos);
+            } while (ok && (end ? left != 0 : zin.pos < zin.size));
+        }
+        ZSTD_freeCCtx(cx);
+    }
+#endif
+    out.close();
+    std::error_code ec;
+    if (ok && out && !in.bad()) std::filesystem::rename(tmp, dst, ec);
+    if (!ok || !out || in.bad() || ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+// Move src to dst, or, when c is set and src is not compressed yet, write a compressed
+// copy to dst plus the format's suffix and remove src. Returns the path written, empty
+// on failure (src is then left in place).
+inline std::filesystem::path moveFile(const std::filesystem::path& src, const std::filesystem::path& dst,
+                                      Compression c) {
+    std::error_code ec;
+    if (c == NO_COMPRESSION || compressionOf(src) != NO_COMPRESSION) {
+        std::filesystem::rename(src, dst, ec);
+        return ec ? std::filesystem::path() : dst;
+    }
+    std::filesystem::path out = dst.string() + kCompressionSuffix[c];
+    if (!compressFile(src, out, c)) return std::filesystem::path();
+    std::filesystem::remove(src, ec);
+    return out;
+}
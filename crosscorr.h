@@ -0,0 +1,108 @@
+// Lagged Pearson cross-correlation of player and robot speed, for every lag at once.
+// CC(t) correlates x[i] with y[i + t] over the samples where both exist, with the means
+// and spreads of that overlap (the cc_at_lag() of the Python analyses). The overlap
+// sums of x, x^2, y and y^2 come from prefix sums and the cross sums sum x[i] y[i + t]
+// for all t from one FFT correlation, so a whole curve costs O(n log n) instead of
+// O(n) per lag.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+// In-place iterative radix-2 FFT; a.size() must be a power of two
+inline void fft(std::vector<std::complex<double>>& a, bool inverse) {
+    size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        double ang = 2 * M_PI / len * (inverse ? 1 : -1);
+        std::vector<std::complex<double>> w(len / 2);
+        for (size_t k = 0; k < len / 2; k++) w[k] = std::polar(1.0, ang * k);
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < len / 2; k++) {
+                std::complex<double> u = a[i + k], v = a[i + k + len / 2] * w[k];
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+            }
+        }
+    }
+    if (inverse)
+        for (auto& v : a) v /= double(n);
+}
+
+// sum_i x[i] * y[i + t] for t = -maxLag..maxLag, stored at [t + maxLag]; x and y have
+// the same length and maxLag < that length
+inline std::vector<double> laggedProducts(const std::vector<double>& x, const std::vector<double>& y, int maxLag) {
+    size_t n = x.size(), size = 1;
+    while (size < 2 * n) size <<= 1;
+    std::vector<std::complex<double>> fx(size), fy(size);
+    for (size_t i = 0; i < n; i++) {
+        fx[i] = x[i];
+        fy[i] = y[i];
+    }
+    fft(fx, false);
+    fft(fy, false);
+    for (size_t i = 0; i < size; i++) fx[i] = std::conj(fx[i]) * fy[i];
+    fft(fx, true);
+    std::vector<double> out(2 * maxLag + 1);
+    for (int t = -maxLag; t <= maxLag; t++) out[t + maxLag] = fx[(t + size) % size].real();
+    return out;
+}
+
+// CC(t) for t = -maxLag..maxLag, stored at [t + maxLag]. A lag whose overlap is empty,
+// or where either side is constant, gets 0.
+inline std::vector<double> crossCorrelation(const std::vector<double>& xIn, const std::vector<double>& yIn, int maxLag) {
+    size_t n = xIn.size();
+    std::vector<double> cc(2 * maxLag + 1, 0.0);
+    if (n == 0) return cc;
+
+    // Centering first keeps the one-pass variance sums well conditioned
+    double mx = 0, my = 0;
+    for (size_t i = 0; i < n; i++) mx += xIn[i], my += yIn[i];
+    mx /= n;
+    my /= n;
+    std::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n; i++) x[i] = xIn[i] - mx, y[i] = yIn[i] - my;
+
+    std::vector<double> px(n + 1, 0), pxx(n + 1, 0), py(n + 1, 0), pyy(n + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        px[i + 1] = px[i] + x[i];
+        pxx[i + 1] = pxx[i] + x[i] * x[i];
+        py[i + 1] = py[i] + y[i];
+        pyy[i + 1] = pyy[i] + y[i] * y[i];
+    }
+    // Lengths of the constant runs at both ends: an overlap that is a prefix or suffix
+    // no longer than such a run has zero spread
+    auto runs = [n](const std::vector<double>& v) {
+        size_t head = 1, tail = 1;
+        while (head < n && v[head] == v[0]) head++;
+        while (tail < n && v[n - 1 - tail] == v[n - 1]) tail++;
+        return std::make_pair(head, tail);
+    };
+    auto [xHead, xTail] = runs(xIn);
+    auto [yHead, yTail] = runs(yIn);
+
+    std::vector<double> sxy = laggedProducts(x, y, std::min<int>(maxLag, n - 1));
+    int reach = std::min<int>(maxLag, n - 1);
+    for (int t = -reach; t <= reach; t++) {
+        size_t m = n - std::abs(t);
+        // x[xa, xa + m) pairs with y[ya, ya + m)
+        size_t xa = t >= 0 ? 0 : -t, ya = t >= 0 ? t : 0;
+        bool xFlat = xa == 0 ? m <= xHead : m <= xTail;
+        bool yFlat = ya == 0 ? m <= yHead : m <= yTail;
+        if (xFlat || yFlat) continue;
+        double sx = px[xa + m] - px[xa], sxx = pxx[xa + m] - pxx[xa];
+        double sy = py[ya + m] - py[ya], syy = pyy[ya + m] - pyy[ya];
+        double cov = sxy[t + reach] - sx * sy / m;
+        double vx = sxx - sx * sx / m, vy = syy - sy * sy / m;
+        if (vx <= 0 || vy <= 0) continue;
+        cc[t + maxLag] = std::clamp(cov / std::sqrt(vx * vy), -1.0, 1.0);
+    }
+    return cc;
+}
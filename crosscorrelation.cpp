@@ -0,0 +1,169 @@
+// Player/robot speed cross-correlation over the speed files written by speed.cpp and
+// surveyspeed.cpp (the CC(t) analyses of CC(t)all.py, CC(t)precrisis.py,
+// CC(t)postcrisis.py and surveycrosscorrelation.py in one native pass).
+// For every index it computes the whole CC(t) curve, reports its own best lag and the
+// CC there, then the global best lag (largest sum of |CC| over all indices) and every
+// index's CC at that lag. Results are also written to cc_<folder>[_pre|_post].txt.
+//g++ -std=c++17 -O2 crosscorrelation.cpp -o crosscorrelation -pthread
+//usage: ./crosscorrelation [speed|surveyspeed] [--segment all|pre|post] [--max-lag L] [-j threads]
+//  pre/post keep the lines before/after the first empty line of each file;
+//  the lag range defaults to a quarter of the shortest series, as in the Python scripts
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cmath>
+#include <cstdlib>
+#include "csvreader.h"
+#include "parallel.h"
+#include "crosscorr.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+enum Segment { ALL, PRE, POST };
+
+// Player and robot speeds of one file: header skipped, "-1" frames dropped and, for
+// pre/post, only the part before/after the first empty line kept
+struct SpeedSeries {
+    string index;
+    vector<double> player, robot;
+};
+
+SpeedSeries loadSpeedFile(const fs::path& path, Segment segment) {
+    SpeedSeries s;
+    s.index = path.stem().string();
+    MappedFile file(path.string());
+    string_view text = file.text();
+    bool afterBreak = false;
+    size_t pos = text.find('\n');   // skip header
+    pos = pos == string_view::npos ? text.size() : pos + 1;
+    while (pos < text.size()) {
+        size_t nl = text.find('\n', pos);
+        size_t end = nl == string_view::npos ? text.size() : nl;
+        string_view line = trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        if (line.empty()) {
+            if (segment == PRE) break;
+            afterBreak = true;
+            continue;
+        }
+        if (segment == POST && !afterBreak) continue;
+
+        // Exactly two numbers per line
+        string buf(line);
+        char* p = buf.data();
+        char* q;
+        double player = strtod(p, &q);
+        if (q == p) continue;
+        char* r;
+        double robot = strtod(q, &r);
+        if (r == q || trim(string_view(r)).size() != 0) continue;
+        if (player == -1 || robot == -1) continue;
+        s.player.push_back(player);
+        s.robot.push_back(robot);
+    }
+    return s;
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+    int threads = parseThreads(argc, argv);
+    string folder = "speed";
+    Segment segment = ALL;
+    int maxLag = -1;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--segment" && i + 1 < argc) {
+            string v = argv[++i];
+            segment = v == "pre" ? PRE : v == "post" ? POST : ALL;
+        } else if (arg == "--max-lag" && i + 1 < argc) {
+            maxLag = atoi(argv[++i]);
+        } else if (arg == "-j" || arg == "--threads") {
+            i++;
+        } else if (arg[0] != '-') {
+            folder = arg;
+        }
+    }
+
+    if (!fs::exists(folder) || !fs::is_directory(folder)) {
+        cerr << "Error: '" << folder << "' folder not found.\n";
+        return 1;
+    }
+    const char* segmentName = segment == PRE ? "pre-crisis " : segment == POST ? "post-crisis " : "";
+
+    vector<fs::path> files = indexedFiles(folder, ".txt");
+    vector<SpeedSeries> all = parallelMap<SpeedSeries>(files.size(), threads, [&](size_t k) {
+        return loadSpeedFile(files[k], segment);
+    });
+    vector<SpeedSeries> series;
+    for (SpeedSeries& s : all) {
+        if (s.player.size() < 2) {
+            cout << "❌ Invalid or insufficient " << segmentName << "speed data for index " << s.index << ": "
+                 << s.player.size() << " valid rows\n";
+            continue;
+        }
+        series.push_back(move(s));
+    }
+    if (series.empty()) {
+        cout << "No valid " << segmentName << "data for any index. Exiting.\n";
+        return 0;
+    }
+
+    size_t shortest = series[0].player.size();
+    for (const SpeedSeries& s : series) shortest = min(shortest, s.player.size());
+    if (maxLag < 0) maxLag = shortest / 4;
+
+    // Whole CC(t) curve of every index, computed in parallel
+    vector<vector<double>> curves = parallelMap<vector<double>>(series.size(), threads, [&](size_t k) {
+        return crossCorrelation(series[k].player, series[k].robot, maxLag);
+    });
+
+    // Global best lag: largest sum of |CC(t)| across indices, first one on ties
+    int globalBest = -maxLag;
+    double bestSum = -1;
+    for (int t = -maxLag; t <= maxLag; t++) {
+        double sum = 0;
+        for (const auto& c : curves) sum += fabs(c[t + maxLag]);
+        if (sum > bestSum) bestSum = sum, globalBest = t;
+    }
+
+    string outName = "cc_" + fs::path(folder).filename().string() +
+                     (segment == PRE ? "_pre" : segment == POST ? "_post" : "") + ".txt";
+    ofstream out(outName);
+    if (!out) cerr << "Error: Could not open file " << outName << " for writing." << endl;
+    out << "index bestLag CC(t) CC(global) CC(0)\n";
+
+    cout << fixed << setprecision(4);
+    cout << "\nAggregate " << segmentName << "global best lag (samples): " << globalBest << '\n';
+    double sum0 = 0, sumSq0 = 0, sumG = 0, sumSqG = 0;
+    for (size_t k = 0; k < series.size(); k++) {
+        const vector<double>& c = curves[k];
+        int bestLag = -maxLag;
+        double bestCC = -2.0;
+        for (int t = -maxLag; t <= maxLag; t++)
+            if (c[t + maxLag] > bestCC) bestCC = c[t + maxLag], bestLag = t;
+        double ccGlobal = c[globalBest + maxLag], cc0 = c[maxLag];
+        sum0 += cc0, sumSq0 += cc0 * cc0, sumG += ccGlobal, sumSqG += ccGlobal * ccGlobal;
+        cout << "✅ Index " << series[k].index << ": best lag=" << bestLag << ", CC(t)=" << bestCC
+             << ", CC(global)=" << ccGlobal << '\n';
+        out << series[k].index << ' ' << bestLag << ' ' << setprecision(6) << bestCC << ' ' << ccGlobal << ' '
+            << cc0 << '\n' << setprecision(4);
+    }
+
+    // Population mean/variance across indices, as np.mean/np.var
+    double n = series.size();
+    cout << "\n===== Summary across all indices =====\n";
+    cout << "Count indices            : " << series.size() << '\n';
+    cout << "Number of lag points     : " << 2 * maxLag + 1 << '\n';
+    cout << "Mean  CC(0)              : " << sum0 / n << '\n';
+    cout << "Var   CC(0)              : " << setprecision(6) << sumSq0 / n - (sum0 / n) * (sum0 / n) << '\n';
+    cout << "Global bestLag (samples) : " << globalBest << '\n';
+    cout << "Mean  CC(bestLag)        : " << setprecision(4) << sumG / n << '\n';
+    cout << "Var   CC(bestLag)        : " << setprecision(6) << sumSqG / n - (sumG / n) * (sumG / n) << '\n';
+    cout << "\nResults written to '" << outName << "'.\n";
+    return 0;
+}
@@ -0,0 +1,251 @@
+// Shared reader for the session CSV exports.
+// The file is memory-mapped and split into string_view cells that point straight
+// into the mapping, so a session is never copied into per-cell heap strings.
+// Row/cell splitting matches the old getline(file) + getline(ss, cell, ',') loaders:
+// no empty row after a trailing newline, no empty cell after a trailing comma.
+// Compressed sessions (.csv.gz, .csv.zst; see compression.h) are inflated on a worker
+// thread while CSVFile splits the part that is already out.
+// The cell and row arrays are per-thread scratch buffers (scratch.h), so a worker
+// splitting one file after another does not allocate for them past the first.
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "compression.h"
+#include "profile.h"
+#include "scratch.h"
+
+// Trim whitespace from both ends without copying
+inline std::string_view trim(std::string_view s) {
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+// stod() for a string_view cell: same strtod rules (leading spaces, trailing junk ignored),
+// same exceptions, but parsed from a stack buffer instead of a temporary string
+inline double toDouble(std::string_view s, size_t* idx = nullptr) {
+    char buf[64];
+    std::string big;
+    const char* p;
+    if (s.size() < sizeof(buf)) {
+        s.copy(buf, s.size());
+        buf[s.size()] = '\0';
+        p = buf;
+    } else {
+        big.assign(s);
+        p = big.c_str();
+    }
+    char* end;
+    errno = 0;
+    double v = strtod(p, &end);
+    if (end == p) throw std::invalid_argument("toDouble");
+    if (errno == ERANGE) throw std::out_of_range("toDouble");
+    if (idx) *idx = end - p;
+    return v;
+}
+
+// Strict variant: the whole cell must be a number
+inline bool parseDouble(std::string_view s, double& out) {
+    try {
+        size_t pos;
+        out = toDouble(s, &pos);
+        return pos == s.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// One row of a CSVFile: a view over its cells
+class CSVRow {
+public:
+    CSVRow(const std::string_view* cells, size_t n) : cells_(cells), n_(n) {}
+    size_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    std::string_view operator[](size_t i) const { return cells_[i]; }
+    const std::string_view* begin() const { return cells_; }
+    const std::string_view* end() const { return cells_ + n_; }
+private:
+    const std::string_view* cells_;
+    size_t n_;
+};
+
+// A read-only mapping of a whole file, for tools that only search the raw bytes
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filePath) {
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open " << filePath << std::endl;
+            return;
+        }
+        opened_ = true;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                len_ = st.st_size;
+                madvise(p, len_, MADV_SEQUENTIAL);
+                PROFILE_COUNT(PROF_BYTES_READ, len_);
+            } else {
+                std::cerr << "Error: Could not map " << filePath << std::endl;
+                unreadable_ = true;
+            }
+        }
+        close(fd);
+        Compression c = compressionOf(filePath);
+        if (c == NO_COMPRESSION || !data_) return;
+        if (compressionSupported(c)) {
+            inflater_.reset(new Inflater(std::string_view(data_, len_), c, filePath));
+        } else {
+            std::cerr << "Error: " << filePath << " is compressed; build with -DFIRE2_"
+                      << (c == GZIP ? "ZLIB -lz" : "ZSTD -lzstd") << " to read it" << std::endl;
+            munmap(const_cast<char*>(data_), len_);
+            data_ = nullptr;
+            len_ = 0;
+            unreadable_ = true;
+        }
+    }
+    ~MappedFile() {
+        inflater_.reset();   // the worker reads the mapping
+        if (data_) munmap(const_cast<char*>(data_), len_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False only when the file could not be opened; an empty file is open but has no text
+    bool isOpen() const { return opened_; }
+    // True when the whole text could be read: opened, mapped, and decompressed by a
+    // codec this build has. Waits for the whole text when the file is compressed.
+    bool readable() const { return opened_ && !unreadable_ && !failed(); }
+    // The file's text, decompressed (waiting for the whole of it) when it is compressed.
+    // A file that fails to decompress has no text.
+    std::string_view text() const {
+        if (!inflater_) return std::string_view(data_, len_);
+        return inflater_->failed() ? std::string_view() : inflater_->text();
+    }
+
+    // Incremental access while a compressed file is inflated: available(want) blocks
+    // until want bytes of text are out (returning fewer only at the end), data() is
+    // where they are. Both work on plain files too.
+    bool streaming() const { return inflater_ != nullptr; }
+    size_t available(size_t want) const { return inflater_ ? inflater_->available(want) : len_; }
+    const char* data() const { return inflater_ ? inflater_->data() : data_; }
+    bool failed() const { return inflater_ && inflater_->failed(); }
+
+private:
+    bool opened_ = false, unreadable_ = false;
+    const char* data_ = nullptr;
+    size_t len_ = 0;
+    std::unique_ptr<Inflater> inflater_;
+};
+
+// Lines of a mapped file in order, fn(line) for each, with CSVFile's line rules. The
+// views point into the file's text and stay valid while file is alive. A compressed
+// file is walked as it is inflated. False when it failed to decompress part way.
+template <class Fn>
+inline bool forEachLine(const MappedFile& file, Fn fn) {
+    constexpr size_t kStreamStep = 1 << 20;
+    bool complete = !file.streaming();
+    std::string_view whole = complete ? file.text() : std::string_view();
+    const char* data = whole.data();
+    size_t len = whole.size(), pos = 0;
+    while (pos < len || !complete) {
+        const char* nl = pos < len ? static_cast<const char*>(memchr(data + pos, '\n', len - pos)) : nullptr;
+        if (!nl && !complete) {
+            // The line runs past the inflated text: wait for more. Lines already
+            // handed out stay valid, the text they point into is kept until the end.
+            size_t want = len + kStreamStep;
+            len = file.available(want);
+            data = file.data();
+            complete = len < want;
+            continue;
+        }
+        size_t lineEnd = nl ? nl - data : len;
+        fn(std::string_view(data + pos, lineEnd - pos));
+        pos = lineEnd + 1;
+    }
+    return !file.failed();
+}
+
+// Cells of one line, fn(index, cell) for each, split like CSVFile (no empty cell after
+// a trailing comma). Returns the cell count.
+template <class Fn>
+inline size_t forEachCell(std::string_view line, Fn fn) {
+    size_t n = 0, start = 0;
+    while (start < line.size()) {
+        const char* comma = static_cast<const char*>(memchr(line.data() + start, ',', line.size() - start));
+        size_t cellEnd = comma ? comma - line.data() : line.size();
+        fn(n++, line.substr(start, cellEnd - start));
+        start = cellEnd + 1;
+    }
+    return n;
+}
+
+class CSVFile {
+public:
+    explicit CSVFile(const std::string& filePath) : file_(filePath) {
+        if (file_.streaming()) {
+            split();
+            if (file_.failed()) {   // no half-parsed sessions
+                cells_->clear();
+                rowStart_->clear();
+            }
+            return;
+        }
+        std::string_view t = file_.text();
+        data_ = t.data();
+        len_ = t.size();
+        if (data_) split();
+    }
+
+    size_t size() const { return rowStart_->empty() ? 0 : rowStart_->size() - 1; }
+    bool empty() const { return size() == 0; }
+    CSVRow operator[](size_t i) const {
+        const std::vector<size_t>& start = *rowStart_;
+        return CSVRow(cells_->data() + start[i], start[i + 1] - start[i]);
+    }
+    // The raw file text (decompressed)
+    std::string_view text() const { return file_.text(); }
+
+private:
+    void split() {
+        PROFILE_SCOPE("csv split");
+        std::vector<std::string_view>& cells = *cells_;
+        std::vector<size_t>& rowStart = *rowStart_;
+        // A compressed file is split as it is inflated, so its size is not known up front
+        if (!file_.streaming()) {
+            size_t lines = 0, commas = 0;
+            for (size_t i = 0; i < len_; i++) {
+                lines += data_[i] == '\n';
+                commas += data_[i] == ',';
+            }
+            rowStart.reserve(lines + 2);
+            cells.reserve(commas + lines + 1);
+        }
+        forEachLine(file_, [&](std::string_view line) {
+            rowStart.push_back(cells.size());
+            forEachCell(line, [&](size_t, std::string_view cell) { cells.push_back(cell); });
+        });
+        rowStart.push_back(cells.size());
+        PROFILE_COUNT(PROF_ROWS_PARSED, rowStart.size() - 1);
+    }
+
+    MappedFile file_;
+    const char* data_ = nullptr;
+    size_t len_ = 0;
+    Scratch<std::string_view> cells_;
+    Scratch<size_t> rowStart_;   // cells_ offset of each row, plus one past the end
+};
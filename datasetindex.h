@@ -0,0 +1,198 @@
+// Which participants have which files, from one scan of the dataset folders.
+// The categorization and completeness reports (map.cpp, calibration.cpp) and the
+// routing filters used to walk ".", shook/, noshook/, evolab/, ... again on every run.
+// DatasetIndex lists the .csv files (plain or compressed) of all of them once. It keeps a flat array sorted
+// by 5-character index, folder, then name, plus one Participant entry per index with
+// a bit per folder and file kind, so every lookup is a binary search.
+//
+// The index is saved to .manifest/datasetindex with the mtime of every folder and
+// reused while none of them has changed. Adding, removing or moving a file changes its
+// folder's mtime, so the next run rescans by itself.
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+#include "compression.h"
+
+enum DataFolder { ROOT_DIR, SHOOK_DIR, NOSHOOK_DIR, EVOLAB_DIR, INTERMEDIATE_DIR, SURVEY_DIR, NUM_DATA_FOLDERS };
+inline const char* const kDataFolderNames[NUM_DATA_FOLDERS] = {".", "shook", "noshook", "evolab", "intermediate", "survey"};
+
+// File kinds by name, with the rules of the routing filters
+enum FileKind {
+    KIND_STANDARD_OFFICE = 1,   // "Standard_Office" and not "Tablet" (noshook.cpp)
+    KIND_INTERMEDIATE = 2,      // "intermediate" and not "tablet", any case (intermediatefilter.cpp)
+    KIND_TABLET = 4,            // "tablet", any case
+};
+
+inline unsigned fileKinds(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return tolower(c); });
+    bool tablet = lower.find("tablet") != std::string::npos;
+    unsigned kinds = tablet ? KIND_TABLET : 0;
+    if (name.find("Standard_Office") != std::string::npos && name.find("Tablet") == std::string::npos)
+        kinds |= KIND_STANDARD_OFFICE;
+    if (lower.find("intermediate") != std::string::npos && !tablet) kinds |= KIND_INTERMEDIATE;
+    return kinds;
+}
+
+struct DataFile {
+    std::string index;          // first 5 characters of the name
+    DataFolder folder;
+    std::string name;
+    unsigned kinds;
+    std::filesystem::path path(const std::filesystem::path& root = ".") const {
+        return folder == ROOT_DIR ? root / name : root / kDataFolderNames[folder] / name;
+    }
+};
+
+struct Participant {
+    std::string index;
+    unsigned folders = 0;       // bit f set when folder f has a file of this index
+    unsigned kinds = 0;         // union of the kinds of its files
+    bool in(DataFolder f) const { return folders >> f & 1; }
+};
+
+class DatasetIndex {
+public:
+    explicit DatasetIndex(const std::filesystem::path& root = ".") : root_(root) {
+        namespace fs = std::filesystem;
+        // The cache folder is created before the folder times are taken, so creating it
+        // does not make the index stale on the next run
+        std::error_code ec;
+        fs::create_directories(cachePath().parent_path(), ec);
+        for (int f = 0; f < NUM_DATA_FOLDERS; f++) mtimes_[f] = folderTime(DataFolder(f));
+        if (!load()) {
+            scan();
+            save();
+        }
+        build();
+    }
+
+    bool fromCache() const { return fromCache_; }
+    const std::filesystem::path& root() const { return root_; }
+
+    // Every indexed file, sorted by index, folder, name
+    const std::vector<DataFile>& files() const { return files_; }
+    // Files of one folder, sorted by index then name
+    std::vector<const DataFile*> files(DataFolder f) const {
+        std::vector<const DataFile*> out;
+        for (const DataFile& file : files_)
+            if (file.folder == f) out.push_back(&file);
+        return out;
+    }
+    bool folderExists(DataFolder f) const { return mtimes_[f] != kMissing; }
+    // True when folder f holds a file with this exact name
+    bool contains(DataFolder f, const std::string& name) const {
+        std::string index = name.substr(0, 5);
+        auto it = std::lower_bound(files_.begin(), files_.end(), std::make_tuple(index, f, name), less);
+        return it != files_.end() && it->folder == f && it->name == name;
+    }
+
+    // One entry per index, sorted
+    const std::vector<Participant>& participants() const { return participants_; }
+    const Participant* find(const std::string& index) const {
+        auto it = std::lower_bound(participants_.begin(), participants_.end(), index,
+                                   [](const Participant& p, const std::string& i) { return p.index < i; });
+        return it != participants_.end() && it->index == index ? &*it : nullptr;
+    }
+
+private:
+    static constexpr int64_t kMissing = INT64_MIN;
+
+    static bool less(const DataFile& a, const std::tuple<std::string, DataFolder, std::string>& b) {
+        return std::tie(a.index, a.folder, a.name) < std::tie(std::get<0>(b), std::get<1>(b), std::get<2>(b));
+    }
+
+    std::filesystem::path folderPath(DataFolder f) const { return f == ROOT_DIR ? root_ : root_ / kDataFolderNames[f]; }
+    std::filesystem::path cachePath() const { return root_ / ".manifest" / "datasetindex"; }
+
+    int64_t folderTime(DataFolder f) const {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(folderPath(f), ec)) return kMissing;
+        auto t = std::filesystem::last_write_time(folderPath(f), ec);
+        return ec ? kMissing : (int64_t)t.time_since_epoch().count();
+    }
+
+    void scan() {
+        namespace fs = std::filesystem;
+        files_.clear();
+        for (int f = 0; f < NUM_DATA_FOLDERS; f++) {
+            if (mtimes_[f] == kMissing) continue;
+            std::error_code ec;
+            for (const auto& entry : fs::directory_iterator(folderPath(DataFolder(f)), ec)) {
+                if (!entry.is_regular_file(ec) || !matchesExtension(entry.path(), ".csv")) continue;
+                std::string name = entry.path().filename().string();
+                files_.push_back({name.substr(0, 5), DataFolder(f), name, fileKinds(name)});
+            }
+        }
+        std::sort(files_.begin(), files_.end(), [](const DataFile& a, const DataFile& b) {
+            return std::tie(a.index, a.folder, a.name) < std::tie(b.index, b.folder, b.name);
+        });
+    }
+
+    // "F2DSIDX1", one mtime line per folder, then "<folder> <name>" per file
+    bool load() {
+        std::ifstream in(cachePath());
+        std::string line;
+        if (!getline(in, line) || line != "F2DSIDX1") return false;
+        for (int f = 0; f < NUM_DATA_FOLDERS; f++) {
+            if (!getline(in, line)) return false;
+            try {
+                if (std::stoll(line) != mtimes_[f]) return false;
+            } catch (...) {
+                return false;
+            }
+        }
+        std::vector<DataFile> files;
+        while (getline(in, line)) {
+            size_t sp = line.find(' ');
+            if (sp == std::string::npos) return false;
+            int f = atoi(line.c_str());
+            if (f < 0 || f >= NUM_DATA_FOLDERS) return false;
+            std::string name = line.substr(sp + 1);
+            files.push_back({name.substr(0, 5), DataFolder(f), name, fileKinds(name)});
+        }
+        files_ = std::move(files);
+        fromCache_ = true;
+        return true;
+    }
+
+    void save() const {
+        std::string tmp = cachePath().string() + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream out(tmp);
+            if (!out) return;   // read-only dataset: keep working from memory
+            out << "F2DSIDX1\n";
+            for (int f = 0; f < NUM_DATA_FOLDERS; f++) out << mtimes_[f] << '\n';
+            for (const DataFile& file : files_) out << file.folder << ' ' << file.name << '\n';
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, cachePath(), ec);
+        if (ec) std::remove(tmp.c_str());
+    }
+
+    void build() {
+        participants_.clear();
+        for (const DataFile& file : files_) {
+            if (participants_.empty() || participants_.back().index != file.index)
+                participants_.push_back({file.index});
+            participants_.back().folders |= 1u << file.folder;
+            participants_.back().kinds |= file.kinds;
+        }
+    }
+
+    std::filesystem::path root_;
+    int64_t mtimes_[NUM_DATA_FOLDERS];
+    bool fromCache_ = false;
+    std::vector<DataFile> files_;
+    std::vector<Participant> participants_;
+};
@@ -0,0 +1,127 @@
+// Multi-pattern event search.
+// EventPatterns compiles a handful of tags ("0.2 seconds", "shook", "start
+// calibration", ...) into one Aho-Corasick automaton, so a buffer is read once for all
+// of them instead of once per tag, and no cell is copied or lowercased on the way.
+// Searches stop as soon as every pattern has been seen.
+//
+// Patterns must not contain ',' or '\n': a match then always lies inside one cell,
+// which is what the per-cell find() loops this replaces looked for.
+#pragma once
+
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// First occurrence of one pattern. row/col count CSV lines and cells from 0; time is
+// filled in by the session lookups. row is -1 when the pattern was not found.
+struct EventHit {
+    int row = -1;
+    int col = -1;
+    double time = NAN;
+    bool found() const { return row >= 0; }
+};
+
+class EventPatterns {
+public:
+    // Up to 64 patterns; ignoreCase folds ASCII letters in both patterns and text
+    explicit EventPatterns(const std::vector<std::string>& patterns, bool ignoreCase = false)
+        : count_(patterns.size()) {
+        for (int c = 0; c < 256; c++) fold_[c] = ignoreCase ? tolower(c) : c;
+        newState();
+        for (size_t p = 0; p < patterns.size(); p++) {
+            int s = 0;
+            for (unsigned char c : patterns[p]) {
+                c = fold_[c];
+                if (next_[s][c] == 0) {
+                    int t = newState();
+                    next_[s][c] = t;
+                }
+                s = next_[s][c];
+            }
+            out_[s] |= uint64_t(1) << p;
+        }
+        // Breadth-first pass turning the trie into a full transition table
+        std::vector<int> fail(next_.size(), 0), queue;
+        for (int c = 0; c < 256; c++)
+            if (next_[0][c]) queue.push_back(next_[0][c]);
+        for (size_t q = 0; q < queue.size(); q++) {
+            int s = queue[q];
+            out_[s] |= out_[fail[s]];
+            for (int c = 0; c < 256; c++) {
+                int t = next_[s][c];
+                if (t) {
+                    fail[t] = next_[fail[s]][c];
+                    queue.push_back(t);
+                } else {
+                    next_[s][c] = next_[fail[s]][c];
+                }
+            }
+        }
+    }
+
+    size_t size() const { return count_; }
+    uint64_t all() const { return count_ == 64 ? ~uint64_t(0) : (uint64_t(1) << count_) - 1; }
+
+    // Bit p set when pattern p occurs anywhere in s
+    uint64_t matches(std::string_view s) const {
+        uint64_t seen = 0;
+        int state = 0;
+        for (unsigned char c : s) {
+            state = next_[state][fold_[c]];
+            seen |= out_[state];
+        }
+        return seen;
+    }
+
+    // First line/cell of each pattern in raw CSV text, starting at line firstLine.
+    // Stops reading as soon as every pattern has been found.
+    std::vector<EventHit> scan(std::string_view text, int firstLine = 0) const {
+        std::vector<EventHit> hits(count_);
+        size_t pos = 0;
+        for (int line = 0; line < firstLine && pos < text.size(); line++) {
+            size_t nl = text.find('\n', pos);
+            pos = nl == std::string_view::npos ? text.size() : nl + 1;
+        }
+        int row = firstLine, col = 0;
+        uint64_t seen = 0;
+        int state = 0;
+        for (; pos < text.size() && seen != all(); pos++) {
+            unsigned char c = text[pos];
+            if (c == '\n') {
+                row++;
+                col = 0;
+                state = 0;
+                continue;
+            }
+            if (c == ',') {
+                col++;
+                state = 0;
+                continue;
+            }
+            state = next_[state][fold_[c]];
+            uint64_t fresh = out_[state] & ~seen;
+            if (fresh) {
+                for (size_t p = 0; p < count_; p++)
+                    if (fresh >> p & 1) hits[p].row = row, hits[p].col = col;
+                seen |= fresh;
+            }
+        }
+        return hits;
+    }
+
+private:
+    int newState() {
+        next_.push_back({});
+        out_.push_back(0);
+        return next_.size() - 1;
+    }
+
+    size_t count_;
+    unsigned char fold_[256];
+    std::vector<std::array<int, 256>> next_;
+    std::vector<uint64_t> out_;
+};
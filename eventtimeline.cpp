@@ -0,0 +1,84 @@
+// Ingest step for the session folders: builds (or refreshes) the .cols and .events
+// sidecars of every CSV, so later tools find both in place (see sessioncache.h and
+// eventtimeline.h). With --print, the timelines of the given indices are listed
+// instead, one "row time cell text" line per event. With --check, every session whose
+// header does not match the column schema (sessionschema.h) cleanly is listed with the
+// fields that are missing, ambiguous or inferred.
+//g++ -std=c++17 -O2 eventtimeline.cpp -o eventtimeline -pthread
+//usage: ./eventtimeline [folder ...] [--print index ...] [--check] [-j threads]
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sessioncache.h"
+#include "parallel.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    vector<string> folders;
+    set<string> print;
+    bool printing = false, checking = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if ((arg == "-j" || arg == "--threads") && i + 1 < argc) i++;
+        else if (arg.rfind("-j", 0) == 0) continue;
+        else if (arg == "--print") printing = true;
+        else if (arg == "--check") checking = true;
+        else if (printing) print.insert(arg);
+        else folders.push_back(arg);
+    }
+    if (folders.empty()) folders = {"shook", "noshook", "survey", "intermediate"};
+    int threads = parseThreads(argc, argv);
+
+    vector<fs::path> files;
+    for (const string& folder : folders) {
+        if (!fs::is_directory(folder)) {
+            cerr << "Skipping '" << folder << "': not a folder" << endl;
+            continue;
+        }
+        for (const fs::path& csv : indexedFiles(folder, ".csv"))
+            if (!printing || print.count(csv.filename().string().substr(0, 5))) files.push_back(csv);
+    }
+
+    vector<size_t> counts(files.size());
+    vector<string> listings = parallelMap<string>(files.size(), threads, [&](size_t k) {
+        SessionColumns data(files[k].string());
+        const vector<EventTimeline::Event>& events = data.timeline().events();
+        counts[k] = events.size();
+        ostringstream out;
+        if (checking && !data.empty()) {
+            uint32_t missing = data.missingFields(), ambiguous = data.ambiguousFields();
+            if (missing || ambiguous || data.luminanceInferred()) {
+                out << files[k].string() << ':';
+                if (missing) out << " missing " << fieldNames(missing) << ';';
+                for (uint32_t m = ambiguous; m; m &= m - 1) {
+                    SessionField f = SessionField(__builtin_ctz(m));
+                    out << " several '" << fieldNames(1u << f) << "' columns, using " << data.column(f) << ';';
+                }
+                if (data.luminanceInferred())
+                    out << " no luminance header, using column " << data.column(COL_LUMINANCE) << " (before leftPupil);";
+                out << '\n';
+            }
+        }
+        if (!printing) return out.str();
+        out << "==== " << files[k].string() << " ====\n" << fixed << setprecision(3);
+        for (const EventTimeline::Event& e : events)
+            out << e.row << '\t' << e.time << '\t' << e.col << '\t' << e.text << '\n';
+        return out.str();
+    });
+
+    size_t total = 0;
+    for (size_t k = 0; k < files.size(); k++) {
+        cout << listings[k];
+        total += counts[k];
+    }
+    if (!printing) cout << "✅ Timelines of " << files.size() << " sessions ready (" << total << " events)" << endl;
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Event timeline of a session CSV: every cell a tag search could match, with its data
+// row, cell and the row's time, in file order.
+// The tools locate their anchors ("0.2 seconds", "shook", "Robot Entered Survey Room",
+// calibration markers) by searching text; the timeline holds the few hundred cells
+// where text can be, so finding an anchor reads a short list instead of the file.
+// It records every non-empty cell of the event columns (headers containing "event",
+// case-insensitive) and any other cell that is not a number, except those of
+// LookingAt, which names the gazed-at object on every frame and is read from the
+// session's string table instead. Every tag has words in
+// it that a number cell cannot contain, so a tag that occurs in a cell occurs in the
+// timeline, and first hits are the same as EventPatterns::scan over the data rows.
+//
+// SessionColumns builds the timeline on the same pass as its columns and keeps it next
+// to the CSV as <file>.csv.events, a small text file ("row<TAB>cell<TAB>time<TAB>text"
+// after a signature line) that scripts can read as well.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+#include "csvreader.h"
+#include "eventlocator.h"
+
+class EventTimeline {
+public:
+    struct Event {
+        uint32_t row;         // data row, 0 is the line after the header
+        int32_t col;
+        double time;          // time of the row, NaN when it did not parse
+        std::string text;
+    };
+
+    // From a parsed CSV; time[r] is the parsed time of data row r, skipCol the LookingAt
+    // column (-1 when there is none)
+    static EventTimeline fromCSV(const CSVFile& data, const double* time, int skipCol = -1) {
+        EventTimeline t;
+        if (data.empty()) return t;
+        std::vector<char> eventCol;
+        for (std::string_view cell : data[0]) eventCol.push_back(isEventHeader(cell));
+        for (size_t r = 1; r < data.size(); r++) {
+            CSVRow row = data[r];
+            for (size_t c = 0; c < row.size(); c++)
+                if ((int)c != skipCol && keeps(c < eventCol.size() && eventCol[c], row[c])) t.add(r - 1, c, time[r - 1], row[c]);
+        }
+        return t;
+    }
+
+    // The rules of fromCSV, for parsers that build the timeline on their own pass:
+    // a column is an event column when its header contains "event" (any case), and a
+    // cell is kept when it is a non-empty event cell or any other cell that is not a
+    // number
+    static bool isEventHeader(std::string_view header) {
+        static const EventPatterns event({"event"}, true);
+        return event.matches(header) != 0;
+    }
+    static bool keeps(bool eventColumn, std::string_view cell) {
+        return eventColumn ? !trim(cell).empty() : !isNumberCell(cell);
+    }
+    void add(uint32_t row, int32_t col, double time, std::string_view text) {
+        events_.push_back({row, col, time, std::string(text)});
+    }
+
+    // False when the file is missing or was written for another version of the CSV
+    bool load(const std::string& path, uint64_t srcSize, int64_t srcMtime) {
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        if (!getline(in, line) || line != signature(srcSize, srcMtime)) return false;
+        std::vector<Event> events;
+        while (getline(in, line)) {
+            size_t a = line.find('\t'), b = line.find('\t', a + 1), c = line.find('\t', b + 1);
+            if (c == std::string::npos) return false;
+            events.push_back({uint32_t(strtoul(line.c_str(), nullptr, 10)), int32_t(atoi(line.c_str() + a + 1)),
+                              strtod(line.c_str() + b + 1, nullptr), line.substr(c + 1)});
+        }
+        events_ = std::move(events);
+        return true;
+    }
+
+    // Written to a temporary name and renamed, so readers never see a partial file
+    void save(const std::string& path, uint64_t srcSize, int64_t srcMtime) const {
+        std::string tmp = path + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (!out) return;   // read-only folder: keep working from memory
+            out << signature(srcSize, srcMtime) << '\n';
+            char buf[64];
+            for (const Event& e : events_) {
+                snprintf(buf, sizeof buf, "%u\t%d\t%.17g\t", e.row, e.col, e.time);
+                out << buf << e.text << '\n';
+            }
+            if (!out) {
+                out.close();
+                std::remove(tmp.c_str());
+                return;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) std::remove(tmp.c_str());
+    }
+
+    const std::vector<Event>& events() const { return events_; }
+
+    // First event of every pattern, in cell col (any cell when col is -1). Events whose
+    // row fails accept(row) are passed over. Stops once all patterns are found.
+    template <class Accept>
+    std::vector<EventHit> find(const EventPatterns& patterns, int col, Accept accept) const {
+        std::vector<EventHit> hits(patterns.size());
+        uint64_t seen = 0;
+        for (size_t i = 0; i < events_.size() && seen != patterns.all(); i++) {
+            const Event& e = events_[i];
+            if (col >= 0 && e.col != col) continue;
+            uint64_t fresh = patterns.matches(e.text) & ~seen;
+            if (!fresh || !accept(e.row)) continue;
+            for (size_t p = 0; p < patterns.size(); p++)
+                if (fresh >> p & 1) hits[p] = {int(e.row), e.col, e.time};
+            seen |= fresh;
+        }
+        return hits;
+    }
+    std::vector<EventHit> find(const EventPatterns& patterns, int col = -1) const {
+        return find(patterns, col, [](size_t) { return true; });
+    }
+
+    // First row whose cell col satisfies pred, -1 if none
+    template <class Pred>
+    int findIf(int col, Pred pred) const {
+        for (const Event& e : events_)
+            if (e.col == col && pred(std::string_view(e.text))) return e.row;
+        return -1;
+    }
+
+private:
+    static std::string signature(uint64_t srcSize, int64_t srcMtime) {
+        return "F2EVENTS1\t" + std::to_string(srcSize) + "\t" + std::to_string(srcMtime);
+    }
+
+    // Empty, only digits, signs, '.', exponents and spaces, or taken whole by strtod.
+    // The character test settles almost every cell without calling strtod.
+    static bool isNumberCell(std::string_view cell) {
+        bool plain = true;
+        for (char ch : cell)
+            if (!((ch >= '0' && ch <= '9') || ch == '.' || ch == '-' || ch == '+' || ch == 'e' || ch == 'E' ||
+                  ch == ' ' || ch == '\t' || ch == '\r')) {
+                plain = false;
+                break;
+            }
+        double v;
+        std::string_view t = trim(cell);
+        return t.empty() || plain || parseDouble(t, v);
+    }
+
+    std::vector<Event> events_;
+};
@@ -0,0 +1,117 @@
+// Expected pupil sizes of the window luminances.
+// Every luminance of a participant's before and after windows is mapped through their
+// calibration table (output_mappings/<index>_luminance_mapping.txt) to the pupil size
+// the calibration expects at that luminance. ExpectedReport aggregates the results
+// over all data points and over the per-person averages. luminanceexpected.cpp feeds it
+// the luminance/<index>luminance.txt files, pipeline.cpp the windows in memory.
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "calibrationtable.h"
+#include "resultsink.h"
+#include "stats.h"
+
+// Stats of the expected pupil sizes of one participant. Invalid (-1) conversions are
+// left out; values are converted as they arrive, so memory does not grow with the input.
+struct ExpectedPupils {
+    explicit ExpectedPupils(QuantileMode quantiles = NO_QUANTILES)
+        : leftBefore(quantiles), rightBefore(quantiles), leftAfter(quantiles), rightAfter(quantiles) {}
+
+    std::ostringstream log, err;
+    SummaryStats leftBefore, rightBefore, leftAfter, rightAfter;
+    double avgLeftBefore = -1, avgRightBefore = -1, avgLeftAfter = -1, avgRightAfter = -1;
+};
+
+// Expected pupils of index. mapping is nullptr when the index has no mapping file;
+// source(fn) hands every window luminance to fn(isAfter, luminance).
+template <class Source>
+ExpectedPupils expectedPupils(const std::string& index, const CalibrationTable* mapping, CalibrationTable::Lookup mode,
+                              QuantileMode quantiles, Source source) {
+    ExpectedPupils res(quantiles);
+    res.log << "Processing luminance file for index " << index << "..." << std::endl;
+    std::string mappingFilename = index + "_luminance_mapping.txt";
+    if (!mapping) {
+        res.err << "Warning: Mapping file " << mappingFilename << " not found. Skipping index " << index << std::endl;
+        return res;
+    }
+    if (mapping->empty()) {
+        res.err << "Warning: Mapping file " << mappingFilename << " is empty. Skipping index " << index << std::endl;
+        return res;
+    }
+
+    source([&](bool isAfter, double lum) {
+        double left = mapping->expected(CalibrationTable::LEFT, lum, mode);
+        double right = mapping->expected(CalibrationTable::RIGHT, lum, mode);
+        if (left != -1) (isAfter ? res.leftAfter : res.leftBefore).add(left);
+        if (right != -1) (isAfter ? res.rightAfter : res.rightBefore).add(right);
+    });
+
+    // Per-person averages (if there is at least one valid data point).
+    auto fileAvg = [](const SummaryStats& s) { return s.stats.empty() ? -1 : s.stats.mean(); };
+    res.avgLeftBefore = fileAvg(res.leftBefore);
+    res.avgRightBefore = fileAvg(res.rightBefore);
+    res.avgLeftAfter = fileAvg(res.leftAfter);
+    res.avgRightAfter = fileAvg(res.rightAfter);
+    return res;
+}
+
+// Aggregate and per-person statistics of the participants added, in the order added
+class ExpectedReport {
+public:
+    explicit ExpectedReport(QuantileMode quantiles)
+        : globalLB(quantiles), globalLA(quantiles), globalRB(quantiles), globalRA(quantiles),
+          personLB(quantiles), personLA(quantiles), personRB(quantiles), personRA(quantiles) {}
+
+    // Merge one participant, printing its progress lines to out and warnings to cerr
+    void add(const ExpectedPupils& res, std::ostream& out, bool quiet) {
+        printProgress(out, res.log.str(), quiet);
+        std::cerr << res.err.str();
+        globalLB.merge(res.leftBefore);
+        globalRB.merge(res.rightBefore);
+        globalLA.merge(res.leftAfter);
+        globalRA.merge(res.rightAfter);
+        if (res.avgLeftBefore != -1) personLB.add(res.avgLeftBefore);
+        if (res.avgRightBefore != -1) personRB.add(res.avgRightBefore);
+        if (res.avgLeftAfter != -1) personLA.add(res.avgLeftAfter);
+        if (res.avgRightAfter != -1) personRA.add(res.avgRightAfter);
+    }
+
+    void print(std::ostream& out) const {
+        out << "\nExpected Pupil Size Data\n";
+        out << "Aggregate Pupil Size Statistics (all data points):\n";
+        printHalves(out, globalLB, globalRB, globalLA, globalRA);
+        out << "Per Person Average Pupil Size Statistics (aggregated over indices):\n";
+        printHalves(out, personLB, personRB, personLA, personRA);
+    }
+
+private:
+    // Print stats with the given label.
+    static void printStats(std::ostream& out, const std::string& label, const SummaryStats& s) {
+        out << "  " << label << "\n";
+        out << "    Average: " << s.stats.mean() << "\n";
+        out << "    Variance: " << s.stats.variance() << "\n";
+        out << "    Min: " << s.stats.min() << ", Max: " << s.stats.max() << "\n";
+        std::string quantiles = quantileSummary(s);
+        if (!quantiles.empty()) out << "    " << quantiles << "\n";
+    }
+    static void printHalves(std::ostream& out, const SummaryStats& lb, const SummaryStats& rb, const SummaryStats& la,
+                            const SummaryStats& ra) {
+        out << "Before Event:\n";
+        out << "  Left Eye\n";
+        printStats(out, "Left", lb);
+        out << "  Right Eye\n";
+        printStats(out, "Right", rb);
+
+        out << "\nAfter Event:\n";
+        out << "  Left Eye\n";
+        printStats(out, "Left", la);
+        out << "  Right Eye\n";
+        printStats(out, "Right", ra);
+    }
+
+    // Aggregate stats over all data points, and over per-person averages
+    SummaryStats globalLB, globalLA, globalRB, globalRA;
+    SummaryStats personLB, personLA, personRB, personRA;
+};
@@ -3,15 +3,16 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
-#include <algorithm> // For transforming text to lowercase
 #include <iomanip>   // For setting decimal precision
+#include "csvreader.h"
+#include "eventlocator.h"
 
 using namespace std;
 namespace fs = filesystem;
 
-// Function to check if a file has a .csv extension
+// Function to check if a file has a .csv extension (.csv.gz and .csv.zst included)
 bool isCSVFile(const fs::path& filePath) {
-    return filePath.extension() == ".csv";
+    return matchesExtension(filePath, ".csv");
 }
 
 // Function to extract the first 5 characters as an index
@@ -19,12 +20,6 @@ string extractIndex(const string& fileName) {
     return fileName.substr(0, 5); // First 5 characters represent the index
 }
 
-// Function to convert a string to lowercase
-string toLowerCase(string str) {
-    transform(str.begin(), str.end(), str.begin(), ::tolower);
-    return str;
-}
-
 // Struct to store calibration search results for an index
 struct CalibrationResult {
     string index;
@@ -35,51 +30,33 @@ struct CalibrationResult {
     fs::path filePath;  // Store file path for moving
 };
 
-// Function to search for "start calibration" and "finished calibration" in a CSV file
+// Function to search for "start calibration" and "finished calibration" in a CSV file.
+// Both keywords are matched case-insensitively in one pass over the mapped file,
+// which stops as soon as both have been found.
 CalibrationResult searchCalibrationKeywords(const fs::path& filePath) {
-    ifstream file(filePath);
+    PROFILE_FILE("calibration search", filePath.filename().string());
+    static const EventPatterns keywords({"start calibration", "finished calibration"}, true);
     CalibrationResult result;
     result.index = extractIndex(filePath.filename().string());
     result.filePath = filePath;
 
-    if (!file.is_open()) {
-        cerr << "Error: Could not open " << filePath << endl;
-        return result;
-    }
-
-    string line;
-    int rowNum = 0; // Row counter
-
-    while (getline(file, line)) {
-        stringstream ss(line);
-        string cell;
-        int colNum = 0; // Column counter
-
-        while (getline(ss, cell, ',')) {
-            string lowerCell = toLowerCase(cell); // Convert cell text to lowercase
-
-            if (lowerCell.find("start calibration") != string::npos && !result.hasStart) {
-                result.hasStart = true;
-                result.startRow = rowNum;
-                result.startCol = colNum;
-            }
-            if (lowerCell.find("finished calibration") != string::npos && !result.hasFinish) {
-                result.hasFinish = true;
-                result.finishRow = rowNum;
-                result.finishCol = colNum;
-            }
-            colNum++;
-        }
-
-        rowNum++;
-    }
+    MappedFile file(filePath.string());
+    if (!file.isOpen()) return result;
 
-    file.close();
+    vector<EventHit> hits = keywords.scan(file.text());
+    result.hasStart = hits[0].found();
+    result.startRow = hits[0].row;
+    result.startCol = hits[0].col;
+    result.hasFinish = hits[1].found();
+    result.finishRow = hits[1].row;
+    result.finishCol = hits[1].col;
     return result;
 }
 
-int main() {
+int main(int argc, char** argv) {
     string path = "evolab"; // Folder containing the CSV files
+    Compression compress; // --compress gz|zst: store compressed copies in "complete"
+    if (!parseCompressOption(argc, argv, compress)) return 1;
     fs::path completeFolder = fs::path(path) / "complete";
 
     if (!fs::exists(path) || !fs::is_directory(path)) {
@@ -108,9 +85,15 @@ int main() {
                 countBoth++;
 
                 // Move file to "complete" folder
-                fs::path newFilePath = completeFolder / entry.path().filename();
-                fs::rename(entry.path(), newFilePath);
-                cout << "Moved " << entry.path().filename().string() << " to 'complete' folder.\n";
+                fs::path newFilePath;
+                {
+                    PROFILE_FILE("move to complete", entry.path().filename().string());
+                    newFilePath = moveFile(entry.path(), completeFolder / entry.path().filename(), compress);
+                }
+                if (newFilePath.empty())
+                    cerr << "❌ Could not move " << entry.path().filename().string() << " to 'complete' folder.\n";
+                else
+                    cout << "Moved " << entry.path().filename().string() << " to 'complete' folder.\n";
 
             } else if (result.hasStart) {
                 countOnlyStart++;
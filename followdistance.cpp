@@ -0,0 +1,150 @@
+// Player-robot distance and follow metrics of every shook and noshook session, in one
+// pass per file (see followengine.h); replaces the per-row Python loops of
+// followdistance.py, shookfollowdistance.py, noshookfollowdistance.py,
+// playerrobotdistance.py and followdistancetime.py (whose follow time it defines
+// differently, see followengine.h).
+// followdistance.tsv (or -o) gets one row per condition, index and segment (pre, post,
+// overall); stdout gets each session's post-crisis follow distance and, per condition,
+// the mean and variance over sessions as the Python scripts printed them.
+// --series also writes distance/<index>.txt with the per-frame "time distance" series.
+//g++ -std=c++17 -O2 followdistance.cpp -o followdistance -pthread
+//usage: ./followdistance [--threshold 2] [--window 10] [--span seconds] [--condition shook|noshook|both] [--series] [-o followdistance.tsv] [-j threads] [--quiet]
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "followengine.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+string num(double v) {
+    ostringstream ss;
+    if (std::isnan(v)) ss << "NA";
+    else ss << v;
+    return ss.str();
+}
+
+// TSV rows of one session
+string followRows(const Condition& cond, const FollowResult& res) {
+    ostringstream out;
+    for (int k = 0; k < NUM_FOLLOW_SEGMENTS; k++) {
+        const FollowSegmentStats& st = res.segment[k];
+        const RunningStats& d = st.distance;
+        out << cond.name << '\t' << res.fileIndex << '\t' << kFollowSegmentNames[k] << '\t' << d.count() << '\t'
+            << num(d.empty() ? NAN : d.mean()) << '\t' << num(d.count() < 2 ? NAN : d.stddev()) << '\t'
+            << num(d.empty() ? NAN : d.min()) << '\t' << num(d.empty() ? NAN : d.max()) << '\t' << st.timeWithin
+            << '\t' << st.followDistance << '\t' << st.followTime << '\n';
+    }
+    return out.str();
+}
+
+bool writeSeries(const fs::path& path, const FollowResult& res) {
+    ofstream out(path);
+    if (!out) return false;
+    out << "time distance\n";
+    for (size_t i = 0; i < res.time.size(); i++) out << res.time[i] << ' ' << res.distance[i] << '\n';
+    return bool(out);
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    FollowOptions opt;
+    vector<const Condition*> conditions = {&kShook, &kNoshook};
+    string outName = "followdistance.tsv";
+    bool series = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc) opt.threshold = atof(argv[++i]);
+        else if (arg == "--window" && i + 1 < argc) opt.window = atof(argv[++i]);
+        else if (arg == "--span" && i + 1 < argc) opt.span = atof(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc) outName = argv[++i];
+        else if (arg == "--series") series = true;
+        else if (arg == "--condition" && i + 1 < argc) {
+            string c = argv[++i];
+            if (c == "shook") conditions = {&kShook};
+            else if (c == "noshook") conditions = {&kNoshook};
+            else if (c == "both") conditions = {&kShook, &kNoshook};
+            else {
+                cerr << "Error: unknown condition '" << c << "' (shook, noshook, both)" << endl;
+                return 1;
+            }
+        }
+    }
+    if (!(opt.threshold > 0) || !(opt.window >= 0) || !(opt.span >= 0)) {
+        cerr << "Error: --threshold must be positive, --window and --span not negative" << endl;
+        return 1;
+    }
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
+
+    struct Job {
+        const Condition* cond;
+        fs::path csv;
+    };
+    vector<Job> jobs;
+    for (const Condition* cond : conditions) {
+        fs::path folder = fs::path(".") / cond->name;
+        if (!fs::exists(folder) || !fs::is_directory(folder)) {
+            cerr << "Error: '" << cond->name << "' folder does not exist!" << endl;
+            return 1;
+        }
+        for (const fs::path& csv : indexedFiles(folder, ".csv")) jobs.push_back({cond, csv});
+    }
+    const fs::path seriesDir = "distance";
+    if (series && !fs::exists(seriesDir)) fs::create_directory(seriesDir);
+
+    // Only the small per-segment results are kept; series are written by the workers
+    vector<FollowResult> results = parallelMap<FollowResult>(jobs.size(), threads, [&](size_t k) {
+        WindowSession s(jobs[k].csv, *jobs[k].cond);
+        FollowResult res = followSession(s, opt, series);
+        if (series && res.problem.empty() && !writeSeries(seriesDir / (res.fileIndex + ".txt"), res))
+            res.problem = "Could not write " + (seriesDir / (res.fileIndex + ".txt")).string();
+        res.time.clear();
+        res.time.shrink_to_fit();
+        res.distance.clear();
+        res.distance.shrink_to_fit();
+        return res;
+    });
+
+    ofstream out(outName);
+    if (!out) {
+        cerr << "Error: Could not open file " << outName << endl;
+        return 1;
+    }
+    out << "condition\tindex\tsegment\tframes\tmeanDistance\tsdDistance\tminDistance\tmaxDistance\ttimeWithin\t"
+           "followDistance\tfollowTime\n";
+    cout << fixed << setprecision(4);
+    for (const Condition* cond : conditions) {
+        RunningStats post;
+        for (size_t k = 0; k < jobs.size(); k++) {
+            if (jobs[k].cond != cond) continue;
+            const FollowResult& res = results[k];
+            if (!res.problem.empty()) {
+                cout << "❌ " << res.fileIndex << ": " << res.problem << "\n";
+                continue;
+            }
+            out << followRows(*cond, res);
+            double d = res.segment[SEG_POST].followDistance;
+            post.add(d);
+            ostringstream line;
+            line << fixed << setprecision(4) << "✅ (" << cond->name << ") Index " << res.fileIndex
+                 << ": Displacement = " << d << " m\n";
+            printProgress(cout, line.str(), quiet);
+        }
+        if (post.empty()) {
+            cout << "\n⚠️ No " << cond->name << " displacement data found.\n";
+            continue;
+        }
+        cout << "\n📊 " << cond->name << " Summary Statistics:\n";
+        cout << "👉 Files processed: " << post.count() << "\n";
+        cout << "👉 Mean Displacement: " << post.mean() << " m\n";
+        cout << "👉 Variance: " << post.populationVariance() << "\n\n";
+    }
+    cout << "Follow metrics written to " << outName << endl;
+    return 0;
+}
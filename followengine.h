@@ -0,0 +1,159 @@
+// Player-robot distance and follow metrics of a session, split at the crisis.
+// The crisis is the after anchor of the pupil tools' Condition: the "shook" row for
+// shook sessions, 0.229 s past the "0.2 seconds" tag for noshook ones. Rows before it
+// are the pre segment, the rest the post segment; with a span only the span seconds on
+// either side of the crisis are used. One pass over the cached columns gives, per
+// segment:
+//   - the per-frame distance |player - robot| (mean, sd, min, max; playerrobotdistance.py)
+//   - the time spent within the proximity threshold (frame intervals ending in range)
+//   - the follow distance and time: for each robot frame, the latest player frame of
+//     the same segment at most window seconds earlier that lies within the threshold
+//     of the robot is the matched position; the path length between successive
+//     matched positions is the follow distance, the time between their robot frames
+//     the follow time. As in followdistance.py and shookfollowdistance.py, the post
+//     segment's robot frames start after the crisis row. Robot frames between "entered
+//     survey room" and "exited survey room" are skipped and the path restarts at
+//     either event. The follow time is this tool's own definition: followdistancetime.py
+//     also matched later player frames and started at the crisis row, so its columns
+//     are not reproduced.
+// Only frames with a time and all six coordinates count. Overall is pre + post.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "windowengine.h"
+
+struct FollowOptions {
+    double threshold = 2.0;   // metres
+    double window = 10.0;     // seconds a matched player frame may lag the robot frame
+    double span = 0.0;        // seconds either side of the crisis, 0 for whole segments
+};
+
+enum FollowSegment { SEG_PRE, SEG_POST, SEG_OVERALL, NUM_FOLLOW_SEGMENTS };
+inline const char* const kFollowSegmentNames[] = {"pre", "post", "overall"};
+
+struct FollowSegmentStats {
+    RunningStats distance;
+    double timeWithin = 0;
+    double followDistance = 0, followTime = 0;
+};
+
+struct FollowResult {
+    std::string fileIndex;
+    std::string problem;          // why the session was skipped, empty when it was not
+    double crisis = NAN;
+    FollowSegmentStats segment[NUM_FOLLOW_SEGMENTS];
+    std::vector<double> time, distance;   // the frame series, when asked for
+};
+
+inline FollowResult followSession(const WindowSession& s, const FollowOptions& opt, bool keepSeries = false) {
+    PROFILE_SCOPE("follow metrics");
+    FollowResult res;
+    res.fileIndex = s.fileIndex;
+    const SessionColumns& data = s.data;
+    if (data.empty()) {
+        res.problem = "Could not load CSV";
+        return res;
+    }
+    for (SessionField f : {COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ})
+        if (data.column(f) == -1) {
+            res.problem = "PlayerVR/Robot position columns not found";
+            return res;
+        }
+    if (s.rowAfter == -1 || std::isnan(s.afterTime)) {
+        res.problem = std::string("'") + s.condition.afterTag + "' event not found";
+        return res;
+    }
+    res.crisis = s.condition.after.lo(s.afterTime);
+
+    // Usable frames, compacted so the follow search runs over contiguous arrays
+    const double* time = data.values(COL_TIME);
+    const double* col[6] = {data.values(COL_PX), data.values(COL_PY), data.values(COL_PZ),
+                            data.values(COL_RX), data.values(COL_RY), data.values(COL_RZ)};
+    double lo = opt.span > 0 ? res.crisis - opt.span : -INFINITY;
+    double hi = opt.span > 0 ? res.crisis + opt.span : INFINITY;
+    Scratch<double> frames[7];   // time, then player and robot x/y/z
+    Scratch<uint32_t> roomBuf;
+    std::vector<double>& t = *frames[0];
+    std::vector<uint32_t>& room = *roomBuf;
+    for (size_t i = 0; i < data.rows(); i++) {
+        if (std::isnan(time[i]) || time[i] < lo || time[i] >= hi) continue;
+        bool ok = true;
+        for (int c = 0; c < 6 && ok; c++) ok = !std::isnan(col[c][i]);
+        if (!ok) continue;
+        t.push_back(time[i]);
+        for (int c = 0; c < 6; c++) frames[c + 1]->push_back(col[c][i]);
+        room.push_back(data.column(COL_ROOM_EVENT) == -1 ? 0 : data.events(COL_ROOM_EVENT)[i]);
+    }
+
+    const double* p[3] = {frames[1]->data(), frames[2]->data(), frames[3]->data()};
+    const double* r[3] = {frames[4]->data(), frames[5]->data(), frames[6]->data()};
+
+    // Survey room markers, by interned string id
+    std::vector<char> enters(data.stringCount()), exits(data.stringCount());
+    std::string lc;
+    for (uint32_t id = 0; id < data.stringCount(); id++) {
+        lc.assign(trim(data.str(id)));
+        std::transform(lc.begin(), lc.end(), lc.begin(), [](unsigned char c) { return tolower(c); });
+        enters[id] = lc == "entered survey room";
+        exits[id] = lc == "exited survey room";
+    }
+
+    double thr2 = opt.threshold * opt.threshold;
+    auto dist2 = [&](size_t pj, size_t ri) {
+        double dx = p[0][pj] - r[0][ri], dy = p[1][pj] - r[1][ri], dz = p[2][pj] - r[2][ri];
+        return dx * dx + dy * dy + dz * dz;
+    };
+    size_t n = t.size();
+    if (keepSeries) {
+        res.time = t;
+        res.distance.reserve(n);
+    }
+    size_t segStart = 0;
+    int seg = -1;
+    bool inSurvey = false;
+    long matchedAt = -1;          // player frame of the last match, -1 after a reset
+    double matchedTime = 0;
+    for (size_t i = 0; i < n; i++) {
+        int now = t[i] < res.crisis ? SEG_PRE : SEG_POST;
+        if (now != seg) {   // segments never share a path
+            seg = now;
+            segStart = i;
+            matchedAt = -1;
+        }
+        FollowSegmentStats& st = res.segment[seg];
+        double d2 = dist2(i, i);
+        st.distance.add(std::sqrt(d2));
+        if (keepSeries) res.distance.push_back(std::sqrt(d2));
+        if (i > segStart && d2 <= thr2) st.timeWithin += t[i] - t[i - 1];
+
+        if (enters[room[i]] || exits[room[i]]) {
+            inSurvey = enters[room[i]];
+            matchedAt = -1;
+            continue;
+        }
+        if (inSurvey || (seg == SEG_POST && i == segStart)) continue;   // post starts after the crisis row
+        long j = i;
+        for (; j >= (long)segStart && t[i] - t[j] <= opt.window; j--)
+            if (dist2(j, i) <= thr2) break;
+        if (j < (long)segStart || t[i] - t[j] > opt.window) continue;
+        if (matchedAt >= 0) {
+            double dx = p[0][j] - p[0][matchedAt], dy = p[1][j] - p[1][matchedAt], dz = p[2][j] - p[2][matchedAt];
+            st.followDistance += std::sqrt(dx * dx + dy * dy + dz * dz);
+            st.followTime += t[i] - matchedTime;
+        }
+        matchedAt = j;
+        matchedTime = t[i];
+    }
+
+    FollowSegmentStats& all = res.segment[SEG_OVERALL];
+    for (int k : {SEG_PRE, SEG_POST}) {
+        all.distance.merge(res.segment[k].distance);
+        all.timeWithin += res.segment[k].timeWithin;
+        all.followDistance += res.segment[k].followDistance;
+        all.followTime += res.segment[k].followTime;
+    }
+    return res;
+}
@@ -0,0 +1,135 @@
+// Gaze statistics of every participant, in one pass per session (see gazeengine.h);
+// replaces the per-row Python loops of sdgaze.py, lookingatrobot.py, looksatrobot.py
+// and robotface.py.
+// As in the scripts, each index is taken from the first folder that has a CSV for it,
+// in the order given (shook, shook/baseline, noshook, noshook/baseline by default;
+// looksatrobot.py read noshookmodified instead of noshook).
+// gaze.tsv (or -o) gets one row per index with the workbook's columns: SD Gaze [x,y,z],
+// % Looking At Robot, Robot Look Count and Robotface Look Count, each overall, pre and
+// post, NA where the scripts left the cell empty. --angle adds the share of frames
+// whose gaze ray passes within that many degrees of the robot.
+//g++ -std=c++17 -O3 -fopenmp-simd gaze.cpp -o gaze -pthread
+//usage: ./gaze [folder ...] [--angle degrees] [-o gaze.tsv] [-j threads] [--quiet]
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include "gazeengine.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+// Fifteen significant digits, what the workbook keeps of the scripts' floats
+string num(double v) {
+    ostringstream ss;
+    if (std::isnan(v)) ss << "NA";
+    else ss << setprecision(15) << v;
+    return ss.str();
+}
+
+// "[sdx, sdy, sdz]" to six places, as sdgaze.py wrote it
+string sdCell(const GazeSegmentStats& st) {
+    if (std::isnan(st.sd[0])) return "NA";
+    char buf[96];
+    snprintf(buf, sizeof buf, "[%.6f, %.6f, %.6f]", st.sd[0], st.sd[1], st.sd[2]);
+    return buf;
+}
+
+// One TSV row; a segment the scripts could not compute is NA
+string gazeRow(const string& folder, const GazeResult& res, bool angle) {
+    bool split = res.splitRow >= 0;
+    auto has = [&](int k) { return k == GAZE_OVERALL || split; };
+    ostringstream out;
+    out << res.fileIndex << '\t' << folder;
+    for (int k = 0; k < NUM_GAZE_SEGMENTS; k++)
+        out << '\t' << (res.hasGaze && has(k) ? sdCell(res.segment[k]) : "NA");
+    for (int k = 0; k < NUM_GAZE_SEGMENTS; k++)
+        out << '\t' << (res.hasLookingAt && has(k) ? num(res.segment[k].robotPercent()) : "NA");
+    for (int k = 0; k < NUM_GAZE_SEGMENTS; k++)
+        out << '\t' << (res.hasLookingAt && has(k) ? to_string(res.segment[k].robotLooks) : "NA");
+    for (int k = 0; k < NUM_GAZE_SEGMENTS; k++)
+        out << '\t' << (res.hasLookingAt && has(k) ? to_string(res.segment[k].faceLooks) : "NA");
+    if (angle)
+        for (int k = 0; k < NUM_GAZE_SEGMENTS; k++)
+            out << '\t' << (res.hasGaze && res.hasPositions && has(k) ? num(res.segment[k].rayPercent()) : "NA");
+    out << '\n';
+    return out.str();
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    GazeOptions opt;
+    vector<string> folders;
+    string outName = "gaze.tsv";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--angle" && i + 1 < argc) opt.angle = atof(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc) outName = argv[++i];
+        else if ((arg == "-j" || arg == "--threads") && i + 1 < argc) i++;
+        else if (arg.rfind("-", 0) == 0) continue;
+        else folders.push_back(arg);
+    }
+    if (!(opt.angle >= 0 && opt.angle <= 180)) {
+        cerr << "Error: --angle must be between 0 and 180 degrees" << endl;
+        return 1;
+    }
+    if (folders.empty()) folders = {"shook", "shook/baseline", "noshook", "noshook/baseline"};
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
+
+    // First CSV of each index, folders in order
+    map<string, pair<string, fs::path>> byIndex;
+    for (const string& folder : folders) {
+        if (!fs::is_directory(folder)) continue;
+        for (const fs::path& csv : indexedFiles(folder, ".csv"))
+            byIndex.emplace(csv.filename().string().substr(0, 5), make_pair(folder, csv));
+    }
+    if (byIndex.empty()) {
+        cerr << "Error: no session CSVs found in the gaze folders" << endl;
+        return 1;
+    }
+    vector<pair<string, fs::path>> jobs;
+    for (const auto& entry : byIndex) jobs.push_back(entry.second);
+
+    vector<GazeResult> results = parallelMap<GazeResult>(jobs.size(), threads, [&](size_t k) {
+        return gazeSession(jobs[k].second, opt);
+    });
+
+    ofstream out(outName);
+    if (!out) {
+        cerr << "Error: Could not open file " << outName << endl;
+        return 1;
+    }
+    out << "index\tfolder";
+    for (const char* metric : {"SD Gaze [x,y,z]", "% Looking At Robot", "Robot Look Count", "Robotface Look Count"})
+        for (const char* seg : kGazeSegmentNames) out << '\t' << metric << " (" << seg << ")";
+    if (opt.angle > 0)
+        for (const char* seg : kGazeSegmentNames) out << "\t% Gaze Within " << opt.angle << " deg Of Robot (" << seg << ")";
+    out << '\n';
+
+    size_t written = 0;
+    for (size_t k = 0; k < jobs.size(); k++) {
+        const GazeResult& res = results[k];
+        if (!res.problem.empty()) {
+            cout << "❌ " << res.fileIndex << ": " << res.problem << "\n";
+            continue;
+        }
+        out << gazeRow(jobs[k].first, res, opt.angle > 0);
+        written++;
+        ostringstream line;
+        const GazeSegmentStats& all = res.segment[GAZE_OVERALL];
+        line << "✅ Index " << res.fileIndex << " (" << jobs[k].first << "): SD " << sdCell(all) << ", "
+             << num(all.robotPercent()) << "% Robot, " << all.robotLooks << " robot / " << all.faceLooks
+             << " face looks" << (res.splitRow >= 0 ? "" : " (no shook/0.2s split)") << "\n";
+        printProgress(cout, line.str(), quiet);
+    }
+    cout << "Gaze statistics of " << written << " participants written to " << outName << endl;
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Gaze statistics of a session, split at the crisis, over the cached columns:
+//   - the sample sd of Gaze Visualizer x, y and z (sdgaze.py), over the rows where all
+//     three parse
+//   - the share of rows whose LookingAt is "Robot", rows with an empty LookingAt cell
+//     counted in the denominator (lookingatrobot.py)
+//   - the number of runs of consecutive "Robot" rows (looksatrobot.py) and of
+//     "smoothfaced" rows (robotface.py); any other value, an empty cell or a short row
+//     ends a run
+//   - with an angle, the share of frames whose gaze ray (from the player's position
+//     through the Gaze Visualizer point) passes within that angle of the robot's
+//     position, as a geometric check on LookingAt
+// The crisis split is the scripts' rule: the first robotEvent row containing "shook"
+// (any case), else the first row at or past 0.229 s after the "0.2 seconds" tag (the
+// noshook onset of windowengine.h). Pre is the rows before the split row, post the rows
+// after it, overall every row. Both tags come from the session's event timeline.
+//
+// Every segment statistic is a branch-free loop over contiguous arrays that -O3
+// vectorizes; build with -fopenmp-simd so the floating-point sums vectorize too.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "windowengine.h"
+
+struct GazeOptions {
+    double angle = 0.0;   // degrees for the ray test, 0 to skip it
+};
+
+// In the order of the workbook's sheets
+enum GazeSegment { GAZE_OVERALL, GAZE_PRE, GAZE_POST, NUM_GAZE_SEGMENTS };
+inline const char* const kGazeSegmentNames[] = {"Overall", "Pre", "Post"};
+
+struct GazeSegmentStats {
+    size_t gazeRows = 0;       // rows with all three gaze coordinates
+    double sd[3] = {NAN, NAN, NAN};
+    size_t lookRows = 0;       // rows long enough to have a LookingAt cell
+    size_t robotRows = 0;
+    size_t robotLooks = 0, faceLooks = 0;
+    size_t rayFrames = 0, rayHits = 0;
+
+    double robotPercent() const { return lookRows ? robotRows * 100.0 / lookRows : NAN; }
+    double rayPercent() const { return rayFrames ? rayHits * 100.0 / rayFrames : NAN; }
+};
+
+struct GazeResult {
+    std::string fileIndex;
+    std::string problem;            // why the session was skipped, empty when it was not
+    bool hasGaze = false, hasLookingAt = false, hasPositions = false;
+    int splitRow = -1;              // data row of the crisis split, -1 when not found
+    GazeSegmentStats segment[NUM_GAZE_SEGMENTS];
+};
+
+// Data row the scripts split pre and post at, -1 when neither tag is found
+inline int crisisSplitRow(const SessionColumns& data) {
+    static const EventPatterns tags({"shook", "0.2 seconds"}, true);
+    std::vector<EventHit> hits = data.findEvents(COL_ROBOT_EVENT, tags);
+    if (hits[0].found()) return hits[0].row;
+    if (!hits[1].found() || std::isnan(hits[1].time)) return -1;
+    double onset = kNoshook.after.lo(hits[1].time);
+    const double* time = data.values(COL_TIME);
+    for (size_t r = hits[1].row; r < data.rows(); r++)
+        if (time[r] >= onset) return r;
+    return -1;
+}
+
+// Sample sd of each gaze axis over rows [lo, hi) where all three parsed; two passes,
+// as numpy's std(ddof=1)
+inline void gazeSd(const double* const g[3], size_t lo, size_t hi, GazeSegmentStats& st) {
+    const double *gx = g[0], *gy = g[1], *gz = g[2];
+    double n = 0, sx = 0, sy = 0, sz = 0;
+#pragma omp simd reduction(+ : n, sx, sy, sz)
+    for (size_t i = lo; i < hi; i++) {
+        bool ok = !std::isnan(gx[i]) & !std::isnan(gy[i]) & !std::isnan(gz[i]);
+        n += ok;
+        sx += ok ? gx[i] : 0.0;
+        sy += ok ? gy[i] : 0.0;
+        sz += ok ? gz[i] : 0.0;
+    }
+    st.gazeRows = n;
+    if (n < 2) return;
+    double mx = sx / n, my = sy / n, mz = sz / n;
+    double qx = 0, qy = 0, qz = 0;
+#pragma omp simd reduction(+ : qx, qy, qz)
+    for (size_t i = lo; i < hi; i++) {
+        bool ok = !std::isnan(gx[i]) & !std::isnan(gy[i]) & !std::isnan(gz[i]);
+        double dx = ok ? gx[i] - mx : 0.0, dy = ok ? gy[i] - my : 0.0, dz = ok ? gz[i] - mz : 0.0;
+        qx += dx * dx;
+        qy += dy * dy;
+        qz += dz * dz;
+    }
+    st.sd[0] = std::sqrt(qx / (n - 1));
+    st.sd[1] = std::sqrt(qy / (n - 1));
+    st.sd[2] = std::sqrt(qz / (n - 1));
+}
+
+// LookingAt counts over rows [lo, hi). ids are the interned LookingAt cells (0 for an
+// empty or missing cell), robot/face the ids of "Robot" and "smoothfaced" (UINT32_MAX
+// when the session has none). A row reaches the LookingAt column when it has a cell
+// there or ends in the comma before it: the CSV split drops an empty last cell, which
+// the scripts' csv reader kept.
+inline void lookCounts(const uint32_t* ids, const uint32_t* cells, uint32_t col, uint32_t robot, uint32_t face,
+                       size_t lo, size_t hi, GazeSegmentStats& st) {
+    size_t rows = 0, robotRows = 0, robotRuns = 0, faceRuns = 0;
+#pragma omp simd reduction(+ : rows, robotRows, robotRuns, faceRuns)
+    for (size_t i = lo; i < hi; i++) {
+        uint32_t prev = i > lo ? ids[i - 1] : 0;
+        rows += cells[i] >= col;
+        robotRows += ids[i] == robot;
+        robotRuns += (ids[i] == robot) & (prev != robot);
+        faceRuns += (ids[i] == face) & (prev != face);
+    }
+    st.lookRows = rows;
+    st.robotRows = robotRows;
+    st.robotLooks = robotRuns;
+    st.faceLooks = faceRuns;
+}
+
+// Frames of [lo, hi) whose gaze ray passes within acos(cosMax) of the robot. p, r and g
+// are the player, robot and gaze x/y/z columns.
+inline void rayHits(const double* const p[3], const double* const r[3], const double* const g[3], double cosMax,
+                    size_t lo, size_t hi, GazeSegmentStats& st) {
+    size_t frames = 0, hits = 0;
+#pragma omp simd reduction(+ : frames, hits)
+    for (size_t i = lo; i < hi; i++) {
+        double gx = g[0][i] - p[0][i], gy = g[1][i] - p[1][i], gz = g[2][i] - p[2][i];
+        double vx = r[0][i] - p[0][i], vy = r[1][i] - p[1][i], vz = r[2][i] - p[2][i];
+        double gg = gx * gx + gy * gy + gz * gz, vv = vx * vx + vy * vy + vz * vz;
+        double dot = gx * vx + gy * vy + gz * vz;
+        // NaN in any coordinate fails both comparisons; a zero-length ray is no frame
+        bool ok = gg > 0 && vv > 0;
+        frames += ok;
+        // dot >= cosMax |g||v| with both sides multiplied by their magnitude (x|x| is
+        // monotonic), so no sqrt is needed
+        hits += ok & (dot * std::fabs(dot) >= cosMax * std::fabs(cosMax) * gg * vv);
+    }
+    st.rayFrames = frames;
+    st.rayHits = hits;
+}
+
+inline GazeResult gazeSession(const std::filesystem::path& csv, const GazeOptions& opt) {
+    PROFILE_SCOPE("gaze statistics");
+    GazeResult res;
+    res.fileIndex = csv.filename().string().substr(0, 5);
+    SessionColumns data(csv.string());
+    if (data.empty()) {
+        res.problem = "Could not load CSV";
+        return res;
+    }
+    res.hasGaze = data.column(COL_GX) >= 0 && data.column(COL_GY) >= 0 && data.column(COL_GZ) >= 0;
+    res.hasLookingAt = data.column(COL_LOOKING_AT) >= 0;
+    res.hasPositions = true;
+    for (SessionField f : {COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ})
+        res.hasPositions = res.hasPositions && data.column(f) >= 0;
+    if (!res.hasGaze && !res.hasLookingAt) {
+        res.problem = "Gaze Visualizer and LookingAt columns not found";
+        return res;
+    }
+    res.splitRow = crisisSplitRow(data);
+
+    size_t n = data.rows();
+    size_t lo[NUM_GAZE_SEGMENTS] = {0, 0, 0}, hi[NUM_GAZE_SEGMENTS] = {n, 0, 0};
+    if (res.splitRow >= 0) {
+        hi[GAZE_PRE] = res.splitRow;
+        lo[GAZE_POST] = res.splitRow + 1;
+        hi[GAZE_POST] = n;
+    }
+    int segments = res.splitRow >= 0 ? NUM_GAZE_SEGMENTS : 1;
+
+    const double* g[3] = {data.values(COL_GX), data.values(COL_GY), data.values(COL_GZ)};
+    const double* p[3] = {data.values(COL_PX), data.values(COL_PY), data.values(COL_PZ)};
+    const double* r[3] = {data.values(COL_RX), data.values(COL_RY), data.values(COL_RZ)};
+    uint32_t robot = UINT32_MAX, face = UINT32_MAX;
+    for (uint32_t id = 1; id < data.stringCount(); id++) {
+        if (data.str(id) == "Robot") robot = id;
+        if (data.str(id) == "smoothfaced") face = id;
+    }
+    double cosMax = std::cos(opt.angle * M_PI / 180.0);
+    for (int k = 0; k < segments; k++) {
+        GazeSegmentStats& st = res.segment[k];
+        if (res.hasGaze) gazeSd(g, lo[k], hi[k], st);
+        if (res.hasLookingAt)
+            lookCounts(data.events(COL_LOOKING_AT), data.cellCounts(), data.column(COL_LOOKING_AT), robot, face,
+                       lo[k], hi[k], st);
+        if (opt.angle > 0 && res.hasGaze && res.hasPositions) rayHits(p, r, g, cosMax, lo[k], hi[k], st);
+    }
+    return res;
+}
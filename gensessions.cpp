@@ -0,0 +1,34 @@
+// Write a synthetic Fire2 dataset (see synthetic.h) to try or benchmark the tools
+// without participant data: shook/, noshook/, survey/, intermediate/, evolab/ and
+// output_mappings/ under the output folder.
+//g++ -std=c++17 -O2 gensessions.cpp -o gensessions -pthread
+//usage: ./gensessions [--participants 6] [--rows 3000] [--seed 1] [--out synthetic] [-j threads]
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "synthetic.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+int main(int argc, char** argv) {
+    SyntheticOptions opt;
+    string out = "synthetic";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--participants" && i + 1 < argc) opt.participants = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--rows" && i + 1 < argc) opt.rows = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc) opt.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--out" && i + 1 < argc) out = argv[++i];
+    }
+    if (opt.rows < 100) {
+        cerr << "Error: --rows must be at least 100 (the calibration markers sit in the first 51 rows)" << endl;
+        return 1;
+    }
+    if (!writeSyntheticDataset(out, opt, parseThreads(argc, argv))) {
+        cerr << "Error: Could not write the dataset to " << out << endl;
+        return 1;
+    }
+    cout << "✅ Wrote " << opt.participants << " synthetic participants (" << opt.rows << " rows per session) to " << out << endl;
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Group-level shook vs noshook comparison of the pupil result tables.
+// Participants are split by the folder their session is in (shook/ or noshook/, from
+// the dataset index), and for each eye the per-participant pupil size before the
+// event, after it, and the change (after - before) are compared with a permutation
+// test and a percentile bootstrap interval of the difference in means
+// (see resample.h). Rows with the -1 "no data" marker are left out of that metric.
+// A tab-separated table goes to stdout; the same --seed always gives the same table.
+//g++ -std=c++17 -O2 groupcompare.cpp -o groupcompare -pthread
+//usage: ./groupcompare [--resamples 100000] [--seed 1] [--level 0.95] [-j threads]
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <sstream>
+#include "datasetindex.h"
+#include "pupiltable.h"
+#include "resample.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+enum GroupMetric { PUPIL_BEFORE, PUPIL_AFTER, PUPIL_CHANGE };
+const char* const kMetricNames[] = {"pupilBefore", "pupilAfter", "pupilChange"};
+
+// Value of a metric for one row, false when a half it needs has no data
+bool metricValue(const PupilRow& row, GroupMetric metric, double& v) {
+    double before = row.half[BEFORE_EVENT].avgSize, after = row.half[AFTER_EVENT].avgSize;
+    if ((metric != PUPIL_AFTER && before == -1) || (metric != PUPIL_BEFORE && after == -1)) return false;
+    v = metric == PUPIL_BEFORE ? before : metric == PUPIL_AFTER ? after : after - before;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    size_t resamples = 100000;
+    uint64_t seed = 1;
+    double level = 0.95;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--resamples" && i + 1 < argc) resamples = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--level" && i + 1 < argc) level = atof(argv[++i]);
+    }
+    if (resamples == 0 || !(level > 0 && level < 1)) {
+        cerr << "Error: --resamples must be positive and --level between 0 and 1" << endl;
+        return 1;
+    }
+    int threads = parseThreads(argc, argv);
+
+    DatasetIndex dataset(".");
+    vector<PupilRow> tables[2] = {readPupilTable("leftpupil.txt"), readPupilTable("rightpupil.txt")};
+    if (tables[0].empty() || tables[1].empty()) {
+        cerr << "Error: One or both pupil data files are empty or could not be read.\n";
+        return 1;
+    }
+
+    cout << "eye\tmetric\tnShook\tnNoshook\tmeanShook\tmeanNoshook\tdifference\tpPermutation\tciLow\tciHigh\tlevel\tresamples\tseed\n";
+    const char* const eyes[] = {"left", "right"};
+    for (int eye = 0; eye < 2; eye++) {
+        for (GroupMetric metric : {PUPIL_BEFORE, PUPIL_AFTER, PUPIL_CHANGE}) {
+            vector<double> shook, noshook;
+            int unassigned = 0;
+            for (const PupilRow& row : tables[eye]) {
+                double v;
+                if (!metricValue(row, metric, v)) continue;
+                // Table keys are the index written as a number (pupilRowKey), which is the
+                // file index itself for the usual 5-digit indices
+                const Participant* p = dataset.find(row.index);
+                bool inShook = p && p->in(SHOOK_DIR), inNoshook = p && p->in(NOSHOOK_DIR);
+                if (inShook == inNoshook) {
+                    unassigned++;   // in neither folder, or in both
+                    continue;
+                }
+                (inShook ? shook : noshook).push_back(v);
+            }
+            if (unassigned) cerr << "Warning: " << unassigned << " " << eyes[eye] << " rows are in neither or both of shook/noshook\n";
+
+            PermutationResult perm = permutationTest(shook, noshook, resamples, seed, threads);
+            BootstrapResult boot = bootstrapMeanDifference(shook, noshook, resamples, level, seed, threads);
+            auto num = [](double v) {
+                ostringstream ss;
+                if (std::isnan(v)) ss << "NA";
+                else ss << v;
+                return ss.str();
+            };
+            cout << eyes[eye] << '\t' << kMetricNames[metric] << '\t' << shook.size() << '\t' << noshook.size() << '\t'
+                 << num(meanOf(shook.data(), shook.size())) << '\t' << num(meanOf(noshook.data(), noshook.size())) << '\t'
+                 << num(perm.observed) << '\t' << num(perm.p) << '\t' << num(boot.low) << '\t' << num(boot.high) << '\t'
+                 << level << '\t' << resamples << '\t' << seed << '\n';
+        }
+    }
+    return 0;
+}
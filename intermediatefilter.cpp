@@ -1,49 +1,28 @@
 #include <iostream>
 #include <filesystem>
 #include <string>
-#include <algorithm>
-#include <cctype>
 #include <set>
 #include <vector>
 #include <iomanip>
+#include "datasetindex.h"
 
 namespace fs = std::filesystem;
 
-// 取檔名前 5 個字元為索引
-std::string extractIndex(const std::string& name) {
-    return name.substr(0, 5);
-}
-
-// 轉小寫
-std::string toLower(std::string s) {
-    std::transform(s.begin(), s.end(), s.begin(),
-                   [](unsigned char c){ return std::tolower(c); });
-    return s;
-}
-
 int main() {
     const std::string targetFolder = "intermediate";
     std::set<std::string> allIndices;             // 全部 index
     std::set<std::string> indicesWithIntermediate;// 有 intermediate 檔的 index
     std::vector<std::pair<fs::path, fs::path>> moves; // 待搬移清單
 
-    // 一次走訪目前目錄
-    for (const auto& entry : fs::directory_iterator(fs::current_path())) {
-        if (!entry.is_regular_file()) continue;
-        if (entry.path().extension() != ".csv")   continue;
-
-        std::string fileName = entry.path().filename().string();
-        std::string idx      = extractIndex(fileName);
-        allIndices.insert(idx);
-
-        std::string lower = toLower(fileName);
-        bool isIntermediate =  lower.find("intermediate") != std::string::npos &&
-                              lower.find("tablet")       == std::string::npos;
+    // 由資料集索引取得目前目錄的 CSV
+    DatasetIndex dataset(fs::current_path());
+    for (const DataFile* file : dataset.files(ROOT_DIR)) {
+        allIndices.insert(file->index);
 
-        if (isIntermediate) {
-            indicesWithIntermediate.insert(idx);
-            fs::path dest = fs::path(targetFolder) / entry.path().filename();
-            moves.emplace_back(entry.path(), dest);
+        if (file->kinds & KIND_INTERMEDIATE) {
+            indicesWithIntermediate.insert(file->index);
+            fs::path dest = fs::path(targetFolder) / file->name;
+            moves.emplace_back(file->path(dataset.root()), dest);
         }
     }
 
@@ -0,0 +1,216 @@
+// Location timelines of every participant, in one pass per session (see
+// locationengine.h); replaces the per-row Python loops of surveyroomlocation.py and
+// the room classification of robotsurveyroomlocation.py and locationtimemap.py.
+// As in the scripts, each index is taken from the first folder that has a CSV for it,
+// in the order given (shook, shook/baseline, noshook, noshook/baseline by default).
+// location.tsv (or -o) gets the time-in-location map: one row per index, actor (player,
+// robot) and location with its seconds and number of entries. stdout gets the player
+// and robot positions at the four survey-room tags, aggregated as surveyroomlocation.py
+// printed them; sessions missing a tag or holding one twice are left out of it.
+// --rooms locates the frames in a region file instead of following the roomEvent tags;
+// --timeline also writes location/<index>.txt with the runs themselves.
+//g++ -std=c++17 -O2 location.cpp -o location -pthread
+//usage: ./location [folder ...] [--rooms rooms.txt] [--timeline] [-o location.tsv] [-j threads] [--quiet]
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include "locationengine.h"
+#include "parallel.h"
+#include "resultsink.h"
+#include "stats.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+// The survey-room tags, in the order surveyroomlocation.py reported them
+const struct {
+    const char* label;
+    LocationActor actor;
+    bool entered;
+} kSurveyTags[] = {
+    {"Robot entered Survey Room", ACTOR_ROBOT, true},
+    {"Entered Survey Room", ACTOR_PLAYER, true},
+    {"Robot exited Survey Room", ACTOR_ROBOT, false},
+    {"Exited Survey Room", ACTOR_PLAYER, false},
+};
+const int kNumSurveyTags = sizeof(kSurveyTags) / sizeof(kSurveyTags[0]);
+
+struct SessionLocations {
+    LocationResult res;
+    string surveyProblem;                  // why the survey positions were left out
+    double position[kNumSurveyTags][6];    // |robot xyz|, |player xyz| at each tag
+};
+
+// Positions at the survey tags, as surveyroomlocation.py read them
+string surveyPositions(const SessionColumns& data, const LocationResult& res, double position[][6]) {
+    for (SessionField f : {COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ})
+        if (data.column(f) == -1) return "missing required column(s)";
+    string missing, duplicate;
+    for (int k = 0; k < kNumSurveyTags; k++) {
+        int found = 0;
+        uint32_t row = 0;
+        for (const RoomEvent& e : res.events)
+            if (e.actor == kSurveyTags[k].actor && e.entered == kSurveyTags[k].entered && e.room == "survey room") {
+                found++;
+                row = e.row;
+            }
+        if (found == 0) missing += string(missing.empty() ? "" : "; ") + "'" + kSurveyTags[k].label + "'";
+        if (found > 1) duplicate += string(duplicate.empty() ? "" : ", ") + "'" + kSurveyTags[k].label + "'";
+        if (found != 1) continue;
+        const SessionField fields[6] = {COL_RX, COL_RY, COL_RZ, COL_PX, COL_PY, COL_PZ};
+        for (int c = 0; c < 6; c++) {
+            double v = data.values(fields[c])[row];
+            if (std::isnan(v) || v == -1) return string("'") + kSurveyTags[k].label + "': position invalid";
+            position[k][c] = std::fabs(v);
+        }
+    }
+    if (!missing.empty()) return "missing tag(s) " + missing;
+    if (!duplicate.empty()) return "duplicate tag(s) " + duplicate;
+    return "";
+}
+
+// location.tsv rows of one session
+string locationRows(const string& folder, const LocationResult& res) {
+    ostringstream out;
+    vector<double> seconds;
+    vector<size_t> entries;
+    for (int a = 0; a < NUM_ACTORS; a++) {
+        res.timeIn((LocationActor)a, seconds, entries);
+        for (size_t id = 0; id < seconds.size(); id++)
+            if (entries[id])
+                out << res.fileIndex << '\t' << folder << '\t' << kActorNames[a] << '\t' << res.names[id] << '\t'
+                    << seconds[id] << '\t' << entries[id] << '\n';
+    }
+    return out.str();
+}
+
+bool writeTimeline(const fs::path& path, const fs::path& csv, const LocationResult& res) {
+    string lines;
+    appendTimeline(lines, csv.filename().string(), res);
+    ofstream out(path);
+    return bool(out << kTimelineHeader << lines);
+}
+
+string triple(const RunningStats* s, bool variance) {
+    char buf[128];
+    double v[3];
+    for (int c = 0; c < 3; c++) {
+        if (s[c].empty()) v[c] = NAN;
+        else if (variance) v[c] = s[c].count() > 1 ? s[c].variance() : NAN;
+        else v[c] = s[c].mean();
+    }
+    snprintf(buf, sizeof buf, "(%.6f, %.6f, %.6f)", v[0], v[1], v[2]);
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    vector<string> folders;
+    string outName = "location.tsv", roomsFile;
+    bool timeline = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--rooms" && i + 1 < argc) roomsFile = argv[++i];
+        else if (arg == "--timeline") timeline = true;
+        else if (arg == "-o" && i + 1 < argc) outName = argv[++i];
+        else if ((arg == "-j" || arg == "--threads") && i + 1 < argc) i++;
+        else if (arg.rfind("-", 0) == 0) continue;
+        else folders.push_back(arg);
+    }
+    RoomMap rooms;
+    if (!roomsFile.empty()) {
+        string error;
+        rooms = RoomMap::load(roomsFile, error);
+        if (!error.empty()) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+    }
+    if (folders.empty()) folders = {"shook", "shook/baseline", "noshook", "noshook/baseline"};
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
+
+    // First CSV of each index, folders in order
+    map<string, pair<string, fs::path>> byIndex;
+    for (const string& folder : folders) {
+        if (!fs::is_directory(folder)) continue;
+        for (const fs::path& csv : indexedFiles(folder, ".csv"))
+            byIndex.emplace(csv.filename().string().substr(0, 5), make_pair(folder, csv));
+    }
+    if (byIndex.empty()) {
+        cerr << "Error: no session CSVs found in the location folders" << endl;
+        return 1;
+    }
+    vector<pair<string, fs::path>> jobs;
+    for (const auto& entry : byIndex) jobs.push_back(entry.second);
+    const fs::path timelineDir = "location";
+    if (timeline && !fs::exists(timelineDir)) fs::create_directory(timelineDir);
+
+    // Timelines are written by the workers and dropped; only their totals are kept
+    vector<SessionLocations> results = parallelMap<SessionLocations>(jobs.size(), threads, [&](size_t k) {
+        SessionLocations s;
+        SessionColumns data(jobs[k].second.string());
+        s.res = locateSession(data, jobs[k].second.filename().string().substr(0, 5), rooms);
+        if (!s.res.problem.empty()) return s;
+        s.surveyProblem = surveyPositions(data, s.res, s.position);
+        fs::path path = timelineDir / (s.res.fileIndex + ".txt");
+        if (timeline && !writeTimeline(path, jobs[k].second, s.res)) s.res.problem = "Could not write " + path.string();
+        return s;
+    });
+
+    ofstream out(outName);
+    if (!out) {
+        cerr << "Error: Could not open file " << outName << endl;
+        return 1;
+    }
+    out << "index\tfolder\tactor\tlocation\tseconds\tentries\n";
+
+    RunningStats robot[kNumSurveyTags][3], player[kNumSurveyTags][3];
+    int shookCount = 0, noshookCount = 0;
+    size_t written = 0;
+    for (size_t k = 0; k < jobs.size(); k++) {
+        const SessionLocations& s = results[k];
+        const string& folder = jobs[k].first;
+        if (!s.res.problem.empty()) {
+            cout << "❌ " << s.res.fileIndex << ": " << s.res.problem << " [folder=" << folder << "]\n";
+            continue;
+        }
+        out << locationRows(folder, s.res);
+        written++;
+        ostringstream line;
+        line << s.res.fileIndex << ": " << s.res.runs[ACTOR_PLAYER].size() << " player / "
+             << s.res.runs[ACTOR_ROBOT].size() << " robot location runs, ";
+        if (!s.surveyProblem.empty()) {
+            line << "survey positions skipped (" << s.surveyProblem << ") [folder=" << folder << "]\n";
+            printProgress(cout, line.str(), quiet);
+            continue;
+        }
+        for (int t = 0; t < kNumSurveyTags; t++)
+            for (int c = 0; c < 3; c++) {
+                robot[t][c].add(s.position[t][c]);
+                player[t][c].add(s.position[t][3 + c]);
+            }
+        (folder.find("noshook") != string::npos ? noshookCount : shookCount)++;
+        line << "survey positions OK [folder=" << folder << "]\n";
+        printProgress(cout, line.str(), quiet);
+    }
+
+    cout << "\n--- Aggregate Results (ABS positions) ---\n";
+    for (int t = 0; t < kNumSurveyTags; t++) {
+        cout << "\n\"" << kSurveyTags[t].label << "\"\n";
+        cout << "  N = " << shookCount + noshookCount << "  (shook+baseline = " << shookCount
+             << ",  noshook+baseline = " << noshookCount << ")\n";
+        cout << "  Robot mean (abs) : " << triple(robot[t], false) << "\n";
+        cout << "  Robot var  (abs) : " << triple(robot[t], true) << "   # sample variance\n";
+        cout << "  Player mean (abs): " << triple(player[t], false) << "\n";
+        cout << "  Player var  (abs): " << triple(player[t], true) << "   # sample variance\n";
+    }
+    cout << "\nLocation timelines of " << written << " participants written to " << outName << endl;
+    return 0;
+}
@@ -0,0 +1,328 @@
+// Room locations of the player and the robot, frame by frame.
+// Every frame of a session is assigned a location, and each of the player and robot
+// gets a run-length-encoded timeline: one run per stretch of frames spent in the same
+// location. The locations come from one of two sources:
+//   - a RoomMap, the floor plan as named regions: polygons in the x/z plane (rooms,
+//     corridors, exits) and spheres (the crisis spot of locationtimemap.py). A frame is
+//     in the first region, in file order, that contains its position, "outside" when
+//     none does and "unknown" when its position did not parse or holds the -1 marker.
+//   - without a map, the session's roomEvent tags, as surveyroomlocation.py and
+//     robotsurveyroomlocation.py read them: "entered <room>" puts the player in the room
+//     and "exited <room>" outside from that frame on, "robot entered/exited <room>" does
+//     the same for the robot. Frames before the first tag are outside.
+// The tags are collected either way (LocationResult::events), so the survey-room
+// positions can be read at them without another scan.
+//
+// A map file has one region per line ('#' starts a comment):
+//   polygon <name> x1 z1 x2 z2 x3 z3 ...
+//   sphere <name> x y z radius
+//   abs                                  compare |x|, |y|, |z|, as the scripts did
+// At load the map's bounds are cut into a uniform grid and each cell keeps the regions
+// whose bounds overlap it, in file order, so locating a frame tests only the one or two
+// regions of its cell instead of every polygon.
+//
+// Timeline files hold one line per run, in the layout of kTimelineHeader. They are
+// tab-separated like location.tsv, since room names from the tags keep their spaces.
+// location.cpp writes them to location/ (one session per index), speed --locations to
+// speedlocation/ (the index's intermediate/ sessions).
+//
+// Only frames with a time count. A run lasts from its first frame to the first frame of
+// the next run (the last run to the session's last frame), so the seconds of a timeline
+// add up to the session's duration.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "sessioncache.h"
+
+enum LocationActor { ACTOR_PLAYER, ACTOR_ROBOT, NUM_ACTORS };
+inline const char* const kActorNames[] = {"player", "robot"};
+
+// Location ids: regions (or tagged rooms) count from 1
+constexpr int32_t kLocationUnknown = -1;   // no usable position
+constexpr int32_t kLocationOutside = 0;    // in no region
+
+class RoomMap {
+public:
+    RoomMap() = default;
+
+    // Map of a region file; on failure an empty map and error says why
+    static RoomMap load(const std::string& path, std::string& error) {
+        RoomMap map;
+        std::ifstream in(path);
+        if (!in) {
+            error = "Could not open " + path;
+            return map;
+        }
+        std::string line;
+        for (int lineNo = 1; getline(in, line); lineNo++) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream iss(line);
+            std::string kind;
+            if (!(iss >> kind)) continue;
+            Region r;
+            std::vector<double> v;
+            double x;
+            if (kind == "abs") {
+                map.abs_ = true;
+                continue;
+            }
+            iss >> r.name;
+            while (iss >> x) v.push_back(x);
+            if (kind == "sphere" && !r.name.empty() && v.size() == 4 && v[3] >= 0) {
+                r.sphere = true;
+                r.cx = v[0], r.cy = v[1], r.cz = v[2], r.radius = v[3];
+                r.minX = r.cx - r.radius, r.maxX = r.cx + r.radius;
+                r.minZ = r.cz - r.radius, r.maxZ = r.cz + r.radius;
+            } else if (kind == "polygon" && !r.name.empty() && v.size() >= 6 && v.size() % 2 == 0 && iss.eof()) {
+                for (size_t k = 0; k < v.size(); k += 2) {
+                    r.xs.push_back(v[k]);
+                    r.zs.push_back(v[k + 1]);
+                }
+                r.minX = *std::min_element(r.xs.begin(), r.xs.end());
+                r.maxX = *std::max_element(r.xs.begin(), r.xs.end());
+                r.minZ = *std::min_element(r.zs.begin(), r.zs.end());
+                r.maxZ = *std::max_element(r.zs.begin(), r.zs.end());
+            } else {
+                error = path + ":" + std::to_string(lineNo) + ": expected 'polygon <name> x z x z x z ...', "
+                        "'sphere <name> x y z radius' or 'abs'";
+                return RoomMap();
+            }
+            map.regions_.push_back(std::move(r));
+        }
+        if (map.regions_.empty()) error = path + " has no regions";
+        else map.buildGrid();
+        return map;
+    }
+
+    bool empty() const { return regions_.empty(); }
+    size_t size() const { return regions_.size(); }
+    // Name of location id (kLocationOutside, kLocationUnknown or a region)
+    const std::string& name(int32_t id) const { return names_[id + 1]; }
+    const std::vector<std::string>& names() const { return names_; }
+
+    // Location of a position; NaN or -1 coordinates are unknown
+    int32_t locate(double x, double y, double z) const {
+        if (std::isnan(x) || std::isnan(y) || std::isnan(z) || x == -1 || y == -1 || z == -1) return kLocationUnknown;
+        if (abs_) x = std::fabs(x), y = std::fabs(y), z = std::fabs(z);
+        if (!(x >= minX_ && x <= maxX_ && z >= minZ_ && z <= maxZ_)) return kLocationOutside;
+        size_t cx = std::min<size_t>((x - minX_) * invCellX_, kGrid - 1);
+        size_t cz = std::min<size_t>((z - minZ_) * invCellZ_, kGrid - 1);
+        size_t cell = cz * kGrid + cx;
+        for (uint32_t k = cellStart_[cell]; k < cellStart_[cell + 1]; k++) {
+            uint32_t r = cellRegions_[k];
+            if (regions_[r].contains(x, y, z)) return r + 1;
+        }
+        return kLocationOutside;
+    }
+
+private:
+    static constexpr size_t kGrid = 64;   // cells per axis
+
+    struct Region {
+        std::string name;
+        bool sphere = false;
+        std::vector<double> xs, zs;            // polygon vertices
+        double cx = 0, cy = 0, cz = 0, radius = 0;
+        double minX = 0, maxX = 0, minZ = 0, maxZ = 0;
+
+        bool contains(double x, double y, double z) const {
+            if (x < minX || x > maxX || z < minZ || z > maxZ) return false;
+            if (sphere) {
+                double dx = x - cx, dy = y - cy, dz = z - cz;
+                return dx * dx + dy * dy + dz * dz <= radius * radius;
+            }
+            // Crossing number in the x/z plane
+            bool in = false;
+            for (size_t i = 0, j = xs.size() - 1; i < xs.size(); j = i++)
+                if ((zs[i] > z) != (zs[j] > z) && x < xs[j] + (z - zs[j]) * (xs[i] - xs[j]) / (zs[i] - zs[j]))
+                    in = !in;
+            return in;
+        }
+    };
+
+    void buildGrid() {
+        names_ = {"unknown", "outside"};
+        minX_ = minZ_ = INFINITY;
+        maxX_ = maxZ_ = -INFINITY;
+        for (const Region& r : regions_) {
+            names_.push_back(r.name);
+            minX_ = std::min(minX_, r.minX), maxX_ = std::max(maxX_, r.maxX);
+            minZ_ = std::min(minZ_, r.minZ), maxZ_ = std::max(maxZ_, r.maxZ);
+        }
+        // A flat map still gets a cell of positive size
+        invCellX_ = maxX_ > minX_ ? kGrid / (maxX_ - minX_) : 0;
+        invCellZ_ = maxZ_ > minZ_ ? kGrid / (maxZ_ - minZ_) : 0;
+        auto cellOf = [](double v, double lo, double inv) {
+            return std::min<size_t>((v - lo) * inv, kGrid - 1);
+        };
+        std::vector<std::vector<uint32_t>> cells(kGrid * kGrid);
+        for (uint32_t i = 0; i < regions_.size(); i++) {
+            const Region& r = regions_[i];
+            for (size_t z = cellOf(r.minZ, minZ_, invCellZ_); z <= cellOf(r.maxZ, minZ_, invCellZ_); z++)
+                for (size_t x = cellOf(r.minX, minX_, invCellX_); x <= cellOf(r.maxX, minX_, invCellX_); x++)
+                    cells[z * kGrid + x].push_back(i);
+        }
+        cellStart_.assign(1, 0);
+        for (const std::vector<uint32_t>& c : cells) {
+            cellRegions_.insert(cellRegions_.end(), c.begin(), c.end());
+            cellStart_.push_back(cellRegions_.size());
+        }
+    }
+
+    std::vector<Region> regions_;
+    std::vector<std::string> names_;
+    bool abs_ = false;
+    double minX_ = 0, maxX_ = 0, minZ_ = 0, maxZ_ = 0, invCellX_ = 0, invCellZ_ = 0;
+    std::vector<uint32_t> cellStart_, cellRegions_;   // regions of cell c: [cellStart_[c], cellStart_[c + 1])
+};
+
+// Frames [first, last] (data rows) in one location, from time start until end
+struct LocationRun {
+    int32_t location;
+    uint32_t first, last;
+    double start, end;
+};
+
+// An "entered"/"exited" roomEvent tag
+struct RoomEvent {
+    uint32_t row;
+    double time;
+    LocationActor actor;
+    bool entered;
+    std::string room;   // lower case, as in the tag
+};
+
+struct LocationResult {
+    std::string fileIndex;
+    std::string problem;               // why the session was skipped, empty when it was not
+    std::vector<std::string> names;    // location id + 1 -> name (unknown, outside, rooms)
+    std::vector<LocationRun> runs[NUM_ACTORS];
+    std::vector<RoomEvent> events;
+
+    const std::string& name(int32_t id) const { return names[id + 1]; }
+    // Seconds and entries (runs) per location id + 1
+    void timeIn(LocationActor a, std::vector<double>& seconds, std::vector<size_t>& entries) const {
+        seconds.assign(names.size(), 0.0);
+        entries.assign(names.size(), 0);
+        for (const LocationRun& r : runs[a]) {
+            seconds[r.location + 1] += r.end - r.start;
+            entries[r.location + 1]++;
+        }
+    }
+};
+
+// The tag of an interned roomEvent string, lower-cased with runs of whitespace
+// collapsed as the scripts normalized it; false when it is not an enter/exit tag
+inline bool parseRoomTag(std::string_view cell, LocationActor& actor, bool& entered, std::string& room) {
+    std::string lc;
+    for (char c : cell) {
+        c = tolower(static_cast<unsigned char>(c));
+        if (isspace(static_cast<unsigned char>(c))) {
+            if (!lc.empty() && lc.back() != ' ') lc += ' ';
+        } else {
+            lc += c;
+        }
+    }
+    if (!lc.empty() && lc.back() == ' ') lc.pop_back();
+    for (bool enter : {true, false}) {
+        std::string verb = enter ? "entered " : "exited ";
+        size_t at = lc.find(verb);
+        if (at == std::string::npos) continue;
+        actor = at >= 6 && lc.compare(at - 6, 6, "robot ") == 0 ? ACTOR_ROBOT : ACTOR_PLAYER;
+        entered = enter;
+        room = lc.substr(at + verb.size());
+        return !room.empty();
+    }
+    return false;
+}
+
+// Location timelines of one session. With a non-empty map the frames are located in
+// it, otherwise they follow the roomEvent tags.
+inline LocationResult locateSession(const SessionColumns& data, const std::string& fileIndex, const RoomMap& map) {
+    PROFILE_SCOPE("location timeline");
+    LocationResult res;
+    res.fileIndex = fileIndex;
+    if (data.empty()) {
+        res.problem = "Could not load CSV";
+        return res;
+    }
+    bool byMap = !map.empty();
+    bool hasRoom = data.column(COL_ROOM_EVENT) != -1;
+    if (byMap) {
+        for (SessionField f : {COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ})
+            if (data.column(f) == -1) {
+                res.problem = "PlayerVR/Robot position columns not found";
+                return res;
+            }
+        res.names = map.names();
+    } else {
+        if (!hasRoom) {
+            res.problem = "'roomEvent' column not found";
+            return res;
+        }
+        res.names = {"unknown", "outside"};
+    }
+
+    // Tag of each interned string, and the location id of its room
+    struct Tag {
+        bool is = false;
+        LocationActor actor;
+        bool entered;
+        std::string room;
+        int32_t id = kLocationOutside;
+    };
+    std::vector<Tag> tags(hasRoom ? data.stringCount() : 0);
+    for (uint32_t s = 0; s < tags.size(); s++) {
+        Tag& t = tags[s];
+        t.is = parseRoomTag(data.str(s), t.actor, t.entered, t.room);
+        if (!t.is || byMap || !t.entered) continue;
+        auto it = std::find(res.names.begin() + 2, res.names.end(), t.room);
+        t.id = it - res.names.begin() - 1;
+        if (it == res.names.end()) res.names.push_back(t.room);
+    }
+
+    const double* time = data.values(COL_TIME);
+    const double* col[6] = {data.values(COL_PX), data.values(COL_PY), data.values(COL_PZ),
+                            data.values(COL_RX), data.values(COL_RY), data.values(COL_RZ)};
+    const uint32_t* room = hasRoom ? data.events(COL_ROOM_EVENT) : nullptr;
+    int32_t current[NUM_ACTORS] = {kLocationOutside, kLocationOutside};
+    for (uint32_t i = 0; i < data.rows(); i++) {
+        if (std::isnan(time[i])) continue;
+        if (room && tags[room[i]].is) {
+            const Tag& t = tags[room[i]];
+            res.events.push_back({i, time[i], t.actor, t.entered, t.room});
+            if (!byMap) current[t.actor] = t.entered ? t.id : kLocationOutside;
+        }
+        for (int a = 0; a < NUM_ACTORS; a++) {
+            int32_t loc = byMap ? map.locate(col[3 * a][i], col[3 * a + 1][i], col[3 * a + 2][i]) : current[a];
+            std::vector<LocationRun>& runs = res.runs[a];
+            if (!runs.empty() && runs.back().location == loc) {
+                runs.back().last = i;
+                runs.back().end = time[i];
+                continue;
+            }
+            if (!runs.empty()) runs.back().end = time[i];
+            runs.push_back({loc, i, i, time[i], time[i]});
+        }
+    }
+    return res;
+}
+
+inline const char kTimelineHeader[] = "session\tactor\tlocation\tfirstRow\tlastRow\tstart\tend\n";
+
+// Timeline-file lines of the runs of one session (a CSV file name)
+inline void appendTimeline(std::string& out, const std::string& session, const LocationResult& res) {
+    std::ostringstream lines;
+    for (int a = 0; a < NUM_ACTORS; a++)
+        for (const LocationRun& r : res.runs[a])
+            lines << session << '\t' << kActorNames[a] << '\t' << res.name(r.location) << '\t' << r.first << '\t'
+                  << r.last << '\t' << r.start << '\t' << r.end << '\n';
+    out += lines.str();
+}
@@ -5,79 +5,85 @@
 #include <filesystem>
 #include <cmath>
 #include <string>
+#include "parallel.h"
+#include "resultsink.h"
+#include "stats.h"
+#include "profile.h"
 
 using namespace std;
 namespace fs = std::filesystem;
 //just calculating the luminance values
-// Function to compute average and sample variance for a vector of doubles.
-void computeStats(const vector<double>& values, double &avg, double &variance) {
-    if (values.empty()) {
-        avg = 0;
-        variance = 0;
-        return;
+// Statistics of one luminance file, split at the empty line into before and after.
+struct LuminanceFile {
+    string log, err;
+    RunningStats before, after;
+};
+
+LuminanceFile readLuminanceFile(const fs::path& path) {
+    PROFILE_FILE("luminance file", path.filename().string());
+    LuminanceFile res;
+    ifstream inFile(path);
+    if (!inFile) {
+        ostringstream err;
+        err << "Error: Could not open file " << path << endl;
+        res.err = err.str();
+        return res;
     }
-    double sum = 0, sumSq = 0;
-    for (double v : values) {
-        sum += v;
-        sumSq += v * v;
+    res.log = "Processing file: " + path.filename().string() + "\n";
+    
+    string line;
+    bool readingBefore = true;
+    size_t bytes = 0, failures = 0;
+    while (getline(inFile, line)) {
+        bytes += line.size() + 1;
+        // Trim the line (optional; assuming no extra spaces)
+        if (line.find_first_not_of(" \t\r\n") == string::npos) {
+            // Empty line indicates separation between before and after.
+            readingBefore = false;
+            continue;
+        }
+        try {
+            double val = stod(line);
+            if (readingBefore)
+                res.before.add(val);
+            else
+                res.after.add(val);
+        } catch (...) {
+            // If conversion fails, skip this line.
+            failures++;
+            continue;
+        }
     }
-    size_t n = values.size();
-    avg = sum / n;
-    if (n > 1)
-        variance = (sumSq - (sum * sum) / n) / (n - 1);
-    else
-        variance = 0;
+    PROFILE_COUNT(PROF_BYTES_READ, bytes);
+    PROFILE_COUNT(PROF_PARSE_FAILURES, failures);
+    return res;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
     fs::path luminanceFolder = fs::path(".") / "luminance";
     if (!fs::exists(luminanceFolder) || !fs::is_directory(luminanceFolder)) {
         cerr << "Error: 'luminance' folder does not exist in the current directory." << endl;
         return 1;
     }
     
-    // Global vectors to store all luminance values from before and after sections.
-    vector<double> globalBefore;
-    vector<double> globalAfter;
+    // Statistics of all luminance values from before and after sections.
+    RunningStats globalBefore;
+    RunningStats globalAfter;
     
-    // Iterate over all txt files in the "luminance" folder.
-    for (const auto& entry : fs::directory_iterator(luminanceFolder)) {
-        if (fs::is_regular_file(entry.path()) && entry.path().extension() == ".txt") {
-            ifstream inFile(entry.path());
-            if (!inFile) {
-                cerr << "Error: Could not open file " << entry.path() << endl;
-                continue;
-            }
-            cout << "Processing file: " << entry.path().filename().string() << endl;
-            
-            string line;
-            bool readingBefore = true;
-            while (getline(inFile, line)) {
-                // Trim the line (optional; assuming no extra spaces)
-                if (line.find_first_not_of(" \t\r\n") == string::npos) {
-                    // Empty line indicates separation between before and after.
-                    readingBefore = false;
-                    continue;
-                }
-                try {
-                    double val = stod(line);
-                    if (readingBefore)
-                        globalBefore.push_back(val);
-                    else
-                        globalAfter.push_back(val);
-                } catch (...) {
-                    // If conversion fails, skip this line.
-                    continue;
-                }
-            }
-            inFile.close();
-        }
+    // Files are read in parallel and their statistics merged in index order.
+    vector<fs::path> files = indexedFiles(luminanceFolder, ".txt");
+    vector<LuminanceFile> results = parallelMap<LuminanceFile>(files.size(), threads, [&](size_t k) { return readLuminanceFile(files[k]); });
+    for (const LuminanceFile& res : results) {
+        cerr << res.err;
+        printProgress(cout, res.log, quiet);
+        globalBefore.merge(res.before);
+        globalAfter.merge(res.after);
     }
     
-    // Compute statistics for both sections.
-    double avgBefore, varBefore, avgAfter, varAfter;
-    computeStats(globalBefore, avgBefore, varBefore);
-    computeStats(globalAfter, avgAfter, varAfter);
+    double avgBefore = globalBefore.mean(), varBefore = globalBefore.variance();
+    double avgAfter = globalAfter.mean(), varAfter = globalAfter.variance();
     
     // Print the final results to the console.
     cout << "\nAggregated Luminance Statistics:" << endl;
@@ -0,0 +1,229 @@
+// Incremental batch runs.
+// A Manifest remembers, per input, the size and mtime of the files the result was
+// computed from (the same staleness rule as the .cols sidecar) together with the
+// result itself, serialized by the tool. With --incremental a tool asks the manifest
+// first and only recomputes inputs that are new or changed; the rest of the report is
+// rebuilt from the recorded results, so the output is the same as a full run.
+//
+// Manifests live in .manifest/<name>, one "key<TAB>signature<TAB>payload" line per
+// input, and are rewritten atomically at the end of every run (incremental or not)
+// with the entries of that run only, so removed inputs drop out.
+//
+// runIndexGroups() is the incremental loop of the tools that write one file per index
+// (speed, surveyspeed): the manifest keeps each index's messages, so an unchanged
+// index prints what it printed when it was computed.
+//
+// upsertRows() is the matching fix for the result tables (leftpupil.txt,
+// rightpupil.txt) that used to be appended to: rows are keyed by their first field and
+// a rerun replaces the rows of the indices it covers instead of adding duplicates.
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "parallel.h"
+
+// True when argv has --incremental
+inline bool parseIncremental(int argc, char** argv) {
+    for (int i = 1; i < argc; i++)
+        if (std::string(argv[i]) == "--incremental") return true;
+    return false;
+}
+
+class Manifest {
+public:
+    explicit Manifest(const std::string& name) : path_(std::filesystem::path(".manifest") / name) {
+        std::ifstream in(path_);
+        std::string line;
+        while (getline(in, line)) {
+            size_t a = line.find('\t');
+            size_t b = a == std::string::npos ? a : line.find('\t', a + 1);
+            if (b == std::string::npos) continue;
+            old_[line.substr(0, a)] = {line.substr(a + 1, b - a - 1), unescape(line.substr(b + 1))};
+        }
+    }
+
+    // Signature of a set of inputs: size and mtime of each, plus a tool-defined config
+    // string (window lengths, ...) so results computed with other settings never match
+    static std::string signature(const std::vector<std::filesystem::path>& inputs, const std::string& config = "") {
+        std::string sig = config;
+        for (const auto& p : inputs) {
+            std::error_code ec;
+            auto size = std::filesystem::file_size(p, ec);
+            if (ec) return "missing";
+            auto mtime = std::filesystem::last_write_time(p, ec).time_since_epoch().count();
+            sig += ' ' + std::to_string(size) + ':' + std::to_string(mtime);
+        }
+        return sig;
+    }
+
+    // Recorded payload of key if it was computed from inputs with this signature.
+    // Safe to call from several threads while nothing is being recorded.
+    const std::string* lookup(const std::string& key, const std::string& sig) const {
+        auto it = old_.find(key);
+        return it != old_.end() && it->second.sig == sig ? &it->second.payload : nullptr;
+    }
+
+    void record(const std::string& key, const std::string& sig, const std::string& payload) {
+        new_[key] = {sig, payload};
+    }
+
+    // Write the entries recorded in this run; false (with the reason on cerr) on failure
+    bool save() const {
+        std::error_code ec;
+        std::filesystem::create_directories(path_.parent_path(), ec);
+        std::string tmp = path_.string() + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream out(tmp);
+            if (!out) {
+                std::cerr << "Error: Could not write manifest " << path_.string() << std::endl;
+                return false;
+            }
+            for (const auto& [key, e] : new_) out << key << '\t' << e.sig << '\t' << escape(e.payload) << '\n';
+        }
+        std::filesystem::rename(tmp, path_, ec);
+        if (ec) {
+            std::remove(tmp.c_str());
+            std::cerr << "Error: Could not write manifest " << path_.string() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Entry {
+        std::string sig, payload;
+    };
+
+    static std::string escape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '\\') out += "\\\\";
+            else if (c == '\n') out += "\\n";
+            else if (c == '\t') out += "\\t";
+            else out += c;
+        }
+        return out;
+    }
+    static std::string unescape(const std::string& s) {
+        std::string out;
+        for (size_t i = 0; i < s.size(); i++) {
+            if (s[i] != '\\' || i + 1 == s.size()) {
+                out += s[i];
+                continue;
+            }
+            char c = s[++i];
+            out += c == 'n' ? '\n' : c == 't' ? '\t' : c;
+        }
+        return out;
+    }
+
+    std::filesystem::path path_;
+    std::map<std::string, Entry> old_, new_;
+};
+
+// Messages of one index, printed by the tool in index order
+struct IndexLog {
+    std::ostringstream out, err;
+};
+
+// Manifest payload of one index: the length of its out messages, a newline, then its
+// out and err messages
+inline std::string savedLog(const IndexLog& log) {
+    std::string out = log.out.str();
+    return std::to_string(out.size()) + "\n" + out + log.err.str();
+}
+
+// Messages of an unchanged index from its manifest payload; false when a file it
+// reported writing has gone missing
+inline bool restoreLog(const std::string& payload, const std::vector<std::filesystem::path>& outputs, IndexLog& log) {
+    size_t nl = payload.find('\n');
+    if (nl == std::string::npos) return false;
+    size_t outLen = strtoul(payload.c_str(), nullptr, 10);
+    if (nl + 1 + outLen > payload.size()) return false;
+    for (const std::filesystem::path& output : outputs)
+        if (outLen > 0 && !std::filesystem::exists(output)) return false;
+    log.out << payload.substr(nl + 1, outLen);
+    log.err << payload.substr(nl + 1 + outLen);
+    return true;
+}
+
+// write(sessions) for every group of groupByIndex(), each index computed and written
+// by one worker, so only the files in flight are held in memory. With incremental, an
+// index whose sessions and extraInputs are unchanged since the last run, and whose
+// outputs(index) are all still there, gets its recorded messages instead. Records
+// every index and saves the manifest; the messages come back in index order.
+template <class Outputs, class Write>
+std::vector<IndexLog> runIndexGroups(Manifest& manifest, const std::vector<std::vector<std::filesystem::path>>& groups,
+                                     const std::vector<std::filesystem::path>& extraInputs, bool incremental,
+                                     int threads, Outputs outputs, Write write) {
+    std::vector<std::string> indices(groups.size()), signatures(groups.size());
+    std::vector<IndexLog> logs = parallelMap<IndexLog>(groups.size(), threads, [&](size_t g) {
+        indices[g] = groups[g].front().filename().string().substr(0, 5);
+        std::vector<std::filesystem::path> inputs = groups[g];
+        inputs.insert(inputs.end(), extraInputs.begin(), extraInputs.end());
+        signatures[g] = Manifest::signature(inputs);
+        const std::string* payload = incremental ? manifest.lookup(indices[g], signatures[g]) : nullptr;
+        IndexLog log;
+        if (payload && restoreLog(*payload, outputs(indices[g]), log)) return log;
+        return write(groups[g]);
+    });
+    for (size_t g = 0; g < groups.size(); g++) manifest.record(indices[g], signatures[g], savedLog(logs[g]));
+    manifest.save();
+    return logs;
+}
+
+// Replace the rows of a whitespace-separated table keyed by their first field: every
+// key in rows gets its new row (at the position of its first old row, or appended),
+// an empty new row deletes the key, and repeated old rows of a key are dropped. When
+// rows holds a key more than once, its last entry is the one that counts.
+// Rows of other keys are kept as they are. The file is rewritten atomically.
+inline bool upsertRows(const std::string& filename, const std::vector<std::pair<std::string, std::string>>& rows) {
+    if (rows.empty()) return true;
+    std::map<std::string, std::string> fresh;
+    for (const auto& [key, row] : rows) fresh[key] = row;
+    std::vector<std::string> lines;
+    std::set<std::string> written;
+    {
+        std::ifstream in(filename);
+        std::string line;
+        while (getline(in, line)) {
+            std::string key = line.substr(0, line.find(' '));
+            auto it = fresh.find(key);
+            if (it == fresh.end()) {
+                lines.push_back(line);
+            } else if (written.insert(key).second && !it->second.empty()) {
+                lines.push_back(it->second);
+            }
+        }
+    }
+    for (const auto& entry : rows) {
+        const std::string& row = fresh[entry.first];
+        if (!row.empty() && written.insert(entry.first).second) lines.push_back(row);
+    }
+
+    std::string tmp = filename + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp);
+        if (!out) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        for (const std::string& l : lines) out << l << '\n';
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) {
+        std::remove(tmp.c_str());
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -2,24 +2,14 @@
 #include <filesystem>
 #include <set>
 #include <iomanip> // For setting decimal precision
+#include "datasetindex.h"
 
 using namespace std;
 namespace fs = filesystem;
 
-// Function to check if a file has a .csv extension
-bool isCSVFile(const fs::path& filePath) {
-    return filePath.extension() == ".csv";
-}
-
-// Function to extract the first 5 characters as an index
-string extractIndex(const string& fileName) {
-    return fileName.substr(0, 5); // First 5 characters represent the index
-}
-
 int main() {
-    string path = "."; // Default to current directory
-    fs::path shookFolder = fs::path(path) / "shook";
-    fs::path noshookFolder = fs::path(path) / "noshook";
+    // One scan of the dataset folders (or the saved index while they are unchanged)
+    DatasetIndex dataset(".");
 
     // Sets to store unique indices
     set<string> uniqueIndicesCurrent; // Unique indices in current directory
@@ -27,45 +17,15 @@ int main() {
     set<string> uniqueIndicesNoshook; // Unique indices in noshook folder
     set<string> missingIndices;       // Indices missing from both shook and noshook
 
-    cout << "Scanning CSV files in the current directory..." << endl;
-
-    // Scan the current directory for unique indices
-    for (const auto& entry : fs::directory_iterator(path)) {
-        if (fs::is_regular_file(entry.path()) && isCSVFile(entry.path())) {
-            string fileName = entry.path().filename().string();
-            string fileIndex = extractIndex(fileName);
-            uniqueIndicesCurrent.insert(fileIndex);
-        }
-    }
-
-    cout << "Scanning CSV files in the shook folder..." << endl;
+    cout << "Scanning CSV files in the current directory, shook and noshook folders"
+         << (dataset.fromCache() ? " (cached index)" : "") << "..." << endl;
 
-    // Scan the shook folder for corresponding indices
-    if (fs::exists(shookFolder) && fs::is_directory(shookFolder)) {
-        for (const auto& entry : fs::directory_iterator(shookFolder)) {
-            if (fs::is_regular_file(entry.path()) && isCSVFile(entry.path())) {
-                string fileName = entry.path().filename().string();
-                string fileIndex = extractIndex(fileName);
-                if (uniqueIndicesCurrent.count(fileIndex)) {  // Only track if it was in the current directory
-                    uniqueIndicesShook.insert(fileIndex);
-                }
-            }
-        }
-    }
-
-    cout << "Scanning CSV files in the noshook folder..." << endl;
-
-    // Scan the noshook folder for corresponding indices
-    if (fs::exists(noshookFolder) && fs::is_directory(noshookFolder)) {
-        for (const auto& entry : fs::directory_iterator(noshookFolder)) {
-            if (fs::is_regular_file(entry.path()) && isCSVFile(entry.path())) {
-                string fileName = entry.path().filename().string();
-                string fileIndex = extractIndex(fileName);
-                if (uniqueIndicesCurrent.count(fileIndex)) {  // Only track if it was in the current directory
-                    uniqueIndicesNoshook.insert(fileIndex);
-                }
-            }
-        }
+    // Only indices that are in the current directory are tracked
+    for (const Participant& p : dataset.participants()) {
+        if (!p.in(ROOT_DIR)) continue;
+        uniqueIndicesCurrent.insert(p.index);
+        if (p.in(SHOOK_DIR)) uniqueIndicesShook.insert(p.index);
+        if (p.in(NOSHOOK_DIR)) uniqueIndicesNoshook.insert(p.index);
     }
 
     cout << "\nChecking data completeness...\n";
@@ -76,7 +36,6 @@ int main() {
             missingIndices.insert(index);
         }
     }
-
     // Print results
     cout << "\n==== Data Categorization Report ====\n";
 
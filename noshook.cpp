@@ -1,22 +1,15 @@
 #include <iostream>
 #include <filesystem>
+#include "compression.h"
+#include "datasetindex.h"
 
 using namespace std;
 namespace fs = filesystem;
 
-// Function to check if a file is valid based on its filename
-bool isValidFile(const string& fileName) {
-    return (fileName.find("Standard_Office") != string::npos) && 
-           (fileName.find("Tablet") == string::npos);
-}
-
-// Function to check if a file has a .csv extension
-bool isCSVFile(const fs::path& filePath) {
-    return filePath.extension() == ".csv";
-}
-
-int main() {
+int main(int argc, char** argv) {
     string path = "."; // Default to current directory
+    Compression compress; // --compress gz|zst: store compressed copies in "noshook"
+    if (!parseCompressOption(argc, argv, compress)) return 1;
     fs::path noshookFolder = fs::path(path) / "noshook";
 
     cout << "Scanning CSV files in the current directory..." << endl;
@@ -27,23 +20,20 @@ int main() {
         fs::create_directory(noshookFolder);
     }
 
-    for (const auto& entry : fs::directory_iterator(path)) {
-        if (fs::is_regular_file(entry.path()) && isCSVFile(entry.path())) {
-            string fileName = entry.path().filename().string();
-
-            // Check if the file is valid
-            if (isValidFile(fileName)) {
-                fs::path destination = noshookFolder / fileName;
-
-                // Check if the file already exists in noshook
-                if (fs::exists(destination)) {
-                    cout << "Skipping: " << fileName << " (Already exists in 'noshook')" << endl;
-                } else {
-                    // Move the file
-                    fs::rename(entry.path(), destination);
-                    cout << "Moved: " << fileName << " -> 'noshook' folder" << endl;
-                }
-            }
+    // Standard_Office sessions that are not Tablet ones, from the dataset index
+    DatasetIndex dataset(path);
+    for (const DataFile* file : dataset.files(ROOT_DIR)) {
+        if (!(file->kinds & KIND_STANDARD_OFFICE)) continue;
+        const string& fileName = file->name;
+
+        // Check if the file already exists in noshook
+        if (dataset.contains(NOSHOOK_DIR, fileName) ||
+            dataset.contains(NOSHOOK_DIR, fileName + kCompressionSuffix[compress])) {
+            cout << "Skipping: " << fileName << " (Already exists in 'noshook')" << '\n';
+        } else if (moveFile(file->path(path), noshookFolder / fileName, compress).empty()) {
+            cerr << "❌ Could not move " << fileName << " to 'noshook'" << endl;
+        } else {
+            cout << "Moved: " << fileName << " -> 'noshook' folder" << '\n';
         }
     }
 
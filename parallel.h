@@ -0,0 +1,127 @@
+// Parallel per-file processing for the batch tools.
+// Files are listed sorted by their 5-character index and handed to a small
+// work-stealing pool: each worker starts with its own share of the files and, once
+// that runs out, steals from the back of another worker's queue, so one large
+// session does not leave the other cores idle. Results come back in list order,
+// so merging them gives the same output whatever the thread count.
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "compression.h"
+
+// Thread count from "-j N", "-jN" or "--threads N"; defaults to one per core
+inline int parseThreads(int argc, char** argv) {
+    int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) threads = atoi(arg.c_str() + 2);
+    }
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return threads;
+}
+
+// Regular files in folder with the given extension, compressed or not (any file when
+// ext is empty), sorted by index then file name
+inline std::vector<std::filesystem::path> indexedFiles(const std::filesystem::path& folder, const std::string& ext) {
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(folder)) {
+        if (std::filesystem::is_regular_file(entry.path()) && (ext.empty() || matchesExtension(entry.path(), ext)))
+            files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end(), [](const std::filesystem::path& a, const std::filesystem::path& b) {
+        std::string fa = a.filename().string(), fb = b.filename().string();
+        int c = fa.compare(0, 5, fb, 0, 5);
+        return c != 0 ? c < 0 : fa < fb;
+    });
+    return files;
+}
+
+// indexedFiles() split into runs that share the same 5-character index
+inline std::vector<std::vector<std::filesystem::path>> groupByIndex(const std::vector<std::filesystem::path>& files) {
+    std::vector<std::vector<std::filesystem::path>> groups;
+    std::string last;
+    for (const auto& f : files) {
+        std::string index = f.filename().string().substr(0, 5);
+        if (groups.empty() || index != last) groups.emplace_back();
+        groups.back().push_back(f);
+        last = index;
+    }
+    return groups;
+}
+
+// Run fn(i) for every i in [0, n) on up to `threads` workers.
+// The first exception thrown by a task is rethrown once all workers have stopped.
+template <class Fn>
+void parallelFor(size_t n, int threads, Fn fn) {
+    size_t workers = std::min<size_t>(std::max(threads, 1), n);
+    if (workers <= 1) {
+        for (size_t i = 0; i < n; i++) fn(i);
+        return;
+    }
+
+    struct Queue {
+        std::mutex m;
+        std::deque<size_t> tasks;
+    };
+    std::vector<Queue> queues(workers);
+    // Round-robin so every worker starts with a mix of early and late files
+    for (size_t i = 0; i < n; i++) queues[i % workers].tasks.push_back(i);
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    auto next = [&](size_t self, size_t& task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[self].m);
+            if (!queues[self].tasks.empty()) {
+                task = queues[self].tasks.front();
+                queues[self].tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < workers; k++) {
+            Queue& victim = queues[(self + k) % workers];
+            std::lock_guard<std::mutex> lock(victim.m);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;   // tasks never spawn tasks, so empty everywhere means done
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; w++) {
+        pool.emplace_back([&, w] {
+            size_t task;
+            while (next(w, task)) {
+                try {
+                    fn(task);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// parallelFor that collects fn(i) into a vector in index order
+template <class R, class Fn>
+std::vector<R> parallelMap(size_t n, int threads, Fn fn) {
+    std::vector<R> results(n);
+    parallelFor(n, threads, [&](size_t i) { results[i] = fn(i); });
+    return results;
+}
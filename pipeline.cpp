@@ -0,0 +1,191 @@
+// The whole pupil workflow in one run: what routefilter, shookpupil/noshookpupil,
+// luminanceshook/luminancenoshook, luminanceexpected and ttestbatch do one after the
+// other, as a stage graph (pipeline.h):
+//   route        raw CSVs into shook/, noshook/, ... (routeengine.h; --no-route skips it)
+//   windows      pupil averages and window luminances of every shook and noshook
+//                session, with both pupil reports (windowengine.h)    after route
+//   calibration  every output_mappings/<index>_luminance_mapping.txt, loaded once
+//   expected     expected pupil sizes of the window luminances (expectedpupil.h)
+//                                                          after windows, calibration
+//   ttest        t-tests of the pupil rows against the calibration (ttestengine.h),
+//                table to -o                               after windows, calibration
+// calibration runs next to route and windows, expected next to ttest. The pupil rows
+// and window luminances go to the later stages in memory, in full precision, so the
+// numbers can differ from the file-based chain in the last printed digits; the rows
+// are those of this run's sessions only, not the ones earlier runs left in
+// leftpupil.txt. --write-intermediate also writes leftpupil.txt, rightpupil.txt and
+// luminance/<index>luminance.txt as the separate tools do.
+//g++ -std=c++17 -O2 pipeline.cpp -o pipeline -pthread
+//usage: ./pipeline [--no-route] [--dry-run] [--link] [--write-intermediate] [--interpolate] [--quantiles|--exact-quantiles] [--alpha 0.05,0.01] [--window before|after|both] [--welch] [-o ttest.tsv] [-j threads] [--incremental] [--quiet] [--binary]
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "pipeline.h"
+#include "routeengine.h"
+#include "windowengine.h"
+#include "expectedpupil.h"
+#include "ttestengine.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+// What the stages hand each other
+struct PipelineState {
+    WindowRun windows;
+    vector<PupilRow> pupilRows[2];                 // leftpupil.txt, rightpupil.txt
+    map<string, CalibrationTable> mappings;        // by index
+};
+
+const string kMappingSuffix = "_luminance_mapping.txt";
+
+// Mapping of index, nullptr when there is no mapping file
+const CalibrationTable* findMapping(const PipelineState& state, const string& index) {
+    auto it = state.mappings.find(index);
+    return it == state.mappings.end() ? nullptr : &it->second;
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    RouteOptions route;
+    bool doRoute = true, writeIntermediate = false, welch = false;
+    CalibrationTable::Lookup mode = CalibrationTable::NEAREST;
+    vector<double> alphas = {0.05};
+    vector<PupilHalf> halves = {BEFORE_EVENT, AFTER_EVENT};
+    string outName = "ttest.tsv";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--no-route") doRoute = false;
+        else if (arg == "--dry-run" || arg == "-n") route.dryRun = true;
+        else if (arg == "--link") route.keepSource = true;
+        else if (arg == "--write-intermediate") writeIntermediate = true;
+        else if (arg == "--interpolate") mode = CalibrationTable::LINEAR;
+        else if (arg == "--welch") welch = true;
+        else if (arg == "-o" && i + 1 < argc) outName = argv[++i];
+        else if (arg == "--alpha" && i + 1 < argc) {
+            try {
+                alphas = parseAlphas(argv[++i]);
+            } catch (...) {
+                cerr << "Error: --alpha takes a comma-separated list of numbers" << endl;
+                return 1;
+            }
+        } else if (arg == "--window" && i + 1 < argc) {
+            string w = argv[++i];
+            if (w == "before") halves = {BEFORE_EVENT};
+            else if (w == "after") halves = {AFTER_EVENT};
+            else if (w == "both") halves = {BEFORE_EVENT, AFTER_EVENT};
+            else {
+                cerr << "Error: unknown window '" << w << "' (before, after, both)" << endl;
+                return 1;
+            }
+        }
+    }
+    WindowRunOptions options = parseWindowRunOptions(argc, argv);
+    QuantileMode quantiles = parseQuantileMode(argc, argv);
+    route.threads = options.threads;
+    bool quiet = options.output.quiet;
+
+    PipelineState state;
+    StageGraph graph;
+
+    graph.add("route", {}, [&](ostream& out) {
+        if (!doRoute) return true;
+        runRouting(route, out);
+        return true;
+    });
+
+    graph.add("windows", {"route"}, [&](ostream& out) {
+        const vector<const Condition*> conditions = {&kShook, &kNoshook};
+        unsigned analyses = PUPIL_AVERAGES | LUMINANCE_VALUES | (writeIntermediate ? LUMINANCE : 0);
+        out << fixed << setprecision(3);
+        if (collectWindowResults(conditions, analyses, options, state.windows, out)) return false;
+        for (size_t c = 0; c < conditions.size(); c++) {
+            vector<const SessionResult*> mine = state.windows.of(c);
+            out << "Scanning CSV files in the " << conditions[c]->name << " folder..." << endl;
+            printPupilReport(out, *conditions[c], mine, options.output, writeIntermediate);
+            if (writeIntermediate) {
+                for (const SessionResult* res : mine) printProgress(out, res->luminanceLog, quiet);
+                out << "Luminance extraction complete." << endl;
+            }
+        }
+        if (options.incremental)
+            cerr << "Incremental: " << state.windows.reused << " of " << state.windows.results.size()
+                 << " sessions unchanged" << endl;
+        collectPupilRows(state.windows, state.pupilRows);
+        return true;
+    });
+
+    graph.add("calibration", {}, [&](ostream& out) {
+        fs::path folder = "output_mappings";
+        if (!fs::is_directory(folder)) {
+            out << "Warning: 'output_mappings' folder does not exist; every index lacks a mapping" << endl;
+            return true;
+        }
+        vector<fs::path> files;
+        for (const fs::path& f : indexedFiles(folder, ".txt")) {
+            string name = f.filename().string();
+            if (name.size() > kMappingSuffix.size() && name.compare(name.size() - kMappingSuffix.size(), string::npos, kMappingSuffix) == 0)
+                files.push_back(f);
+        }
+        vector<CalibrationTable> tables = parallelMap<CalibrationTable>(files.size(), options.threads, [&](size_t k) {
+            return CalibrationTable(files[k].string());
+        });
+        for (size_t k = 0; k < files.size(); k++) {
+            string name = files[k].filename().string();
+            state.mappings[name.substr(0, name.size() - kMappingSuffix.size())] = std::move(tables[k]);
+        }
+        return true;
+    });
+
+    graph.add("expected", {"windows", "calibration"}, [&](ostream& out) {
+        // One entry per index, in index order; a later condition replaces an earlier
+        // one's, as its luminance file would
+        map<string, const SessionResult*> byIndex;
+        for (const SessionResult& res : state.windows.results)
+            if (res.luminanceKept) byIndex[res.fileIndex] = &res;
+        vector<const SessionResult*> sessions;
+        for (const auto& entry : byIndex) sessions.push_back(entry.second);
+        vector<ExpectedPupils> results = parallelMap<ExpectedPupils>(sessions.size(), options.threads, [&](size_t k) {
+            const SessionResult& res = *sessions[k];
+            return expectedPupils(res.fileIndex, findMapping(state, res.fileIndex), mode, quantiles, [&](auto fn) {
+                for (double lum : res.luminance[BEFORE_EVENT]) fn(false, lum);
+                for (double lum : res.luminance[AFTER_EVENT]) fn(true, lum);
+            });
+        });
+        ExpectedReport report(quantiles);
+        for (const ExpectedPupils& res : results) report.add(res, out, quiet);
+        report.print(out);
+        return true;
+    });
+
+    graph.add("ttest", {"windows", "calibration"}, [&](ostream& out) {
+        const vector<PupilRow>& leftRows = state.pupilRows[0];
+        const vector<PupilRow>& rightRows = state.pupilRows[1];
+        if (leftRows.empty() || rightRows.empty()) {
+            out << "Error: No valid pupil rows for one or both eyes; no t-tests run.\n";
+            return false;
+        }
+        vector<string> indices = pupilIndices(leftRows, rightRows);
+        vector<const CalibrationTable*> mappings;
+        for (const string& index : indices) mappings.push_back(findMapping(state, index));
+        TestBatch batch = runTTests(indices, leftRows, rightRows, mappings, halves, welch);
+        ofstream table(outName);
+        if (!table) {
+            out << "Error: Could not open file " << outName << endl;
+            return false;
+        }
+        writeTestTable(table, batch, alphas);
+        out << "\nT-test table of " << batch.index.size() << " tests written to " << outName << '\n';
+        printTestSummary(out, batch, halves, alphas, welch);
+        return true;
+    });
+
+    bool ok = graph.run(cout);
+    if (!quiet) graph.printTimings(cerr);
+    cout << "\nProcessing complete." << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Stages of a batch run as a dependency graph.
+// A stage is a named body that runs once every stage it depends on has completed;
+// stages with no path between them run at the same time, each on its own thread (a
+// stage that has per-file work spreads it over its own parallel.h pool). Results pass
+// between stages in memory, through whatever state the bodies share: a stage only
+// reads what its dependencies wrote, and they finished before it started.
+//
+// Each stage writes its report to a buffer of its own. The buffers are printed in the
+// order the stages were added, each as soon as it and every stage before it are
+// done, so the console output does not depend on which stage finished first. A stage
+// that fails (returns false or throws) skips everything that depends on it; the other
+// branches still run.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class StageGraph {
+public:
+    // Returns false when the stage failed; the reason goes to out
+    using Body = std::function<bool(std::ostream& out)>;
+
+    // Stage name running after deps, which must have been added before it. Unknown
+    // dependencies are an error at run().
+    void add(const std::string& name, const std::vector<std::string>& deps, Body body) {
+        Stage s;
+        s.name = name;
+        s.body = std::move(body);
+        for (const std::string& d : deps) {
+            int k = find(d);
+            if (k < 0) s.error = "unknown dependency '" + d + "'";
+            else s.deps.push_back(k);
+        }
+        stages_.push_back(std::move(s));
+    }
+
+    // Run every stage; false when one of them failed or was skipped
+    bool run(std::ostream& out) {
+        std::mutex m;
+        std::condition_variable changed;
+        std::vector<std::thread> workers;
+        size_t printed = 0;
+        std::unique_lock<std::mutex> lock(m);
+        while (true) {
+            // In add order, so a skip reaches the stages after it in the same pass
+            for (size_t i = 0; i < stages_.size(); i++) {
+                Stage& s = stages_[i];
+                if (s.state != PENDING) continue;
+                if (!s.error.empty()) {
+                    s.output << "Error: stage '" << s.name << "': " << s.error << std::endl;
+                    s.state = FAILED;
+                    continue;
+                }
+                bool ready = true;
+                for (int d : s.deps) {
+                    if (stages_[d].state == FAILED || stages_[d].state == SKIPPED) {
+                        s.output << "Skipping stage '" << s.name << "': '" << stages_[d].name << "' did not complete"
+                                 << std::endl;
+                        s.state = SKIPPED;
+                        break;
+                    }
+                    ready = ready && stages_[d].state == DONE;
+                }
+                if (s.state != PENDING || !ready) continue;
+                s.state = RUNNING;
+                workers.emplace_back([&, i] {
+                    Stage& st = stages_[i];
+                    auto start = std::chrono::steady_clock::now();
+                    bool ok = false;
+                    try {
+                        ok = st.body(st.output);
+                    } catch (const std::exception& e) {
+                        st.output << "Error: stage '" << st.name << "': " << e.what() << std::endl;
+                    }
+                    std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+                    std::lock_guard<std::mutex> g(m);
+                    st.seconds = took.count();
+                    st.state = ok ? DONE : FAILED;
+                    changed.notify_all();
+                });
+            }
+            for (; printed < stages_.size() && stages_[printed].finished(); printed++) out << stages_[printed].output.str();
+            out.flush();
+            if (printed == stages_.size()) break;
+            changed.wait(lock);
+        }
+        lock.unlock();
+        for (std::thread& w : workers) w.join();
+        bool ok = true;
+        for (const Stage& s : stages_) ok = ok && s.state == DONE;
+        return ok;
+    }
+
+    // "name: seconds" of every stage that ran, one per line
+    void printTimings(std::ostream& out) const {
+        for (const Stage& s : stages_)
+            if (s.state == DONE || (s.state == FAILED && s.error.empty()))
+                out << "Stage " << s.name << ": " << std::fixed << std::setprecision(3) << s.seconds << " s\n";
+    }
+
+private:
+    enum State { PENDING, RUNNING, DONE, FAILED, SKIPPED };
+    struct Stage {
+        std::string name;
+        std::vector<int> deps;
+        Body body;
+        std::string error;          // set at add() for a bad dependency
+        State state = PENDING;
+        std::ostringstream output;
+        double seconds = 0;
+        bool finished() const { return state == DONE || state == FAILED || state == SKIPPED; }
+    };
+
+    int find(const std::string& name) const {
+        for (size_t i = 0; i < stages_.size(); i++)
+            if (stages_[i].name == name) return i;
+        return -1;
+    }
+
+    std::vector<Stage> stages_;
+};
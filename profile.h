@@ -0,0 +1,186 @@
+// Scoped timers and counters for finding where a tool's time goes.
+// Everything here compiles to nothing unless the tool is built with -DFIRE2_PROFILE:
+//   PROFILE_SCOPE("stage")              time the enclosing block as a stage
+//   PROFILE_FILE("stage", path)         same, and keep the time of this file
+//   PROFILE_COUNT(PROF_ROWS_PARSED, n)  add n to a counter
+// Scopes may nest and run on any thread. Hot loops count into a local and call
+// PROFILE_COUNT once, so the counters cost nothing per row.
+// At exit the summary (wall time, counters, per-stage count/total/max, per-file times)
+// is written as JSON to profile.json, or to the file named by FIRE2_PROFILE. With
+// FIRE2_TRACE=trace.json every scope is also written as a Chrome trace event
+// (chrome://tracing, ui.perfetto.dev).
+//g++ -std=c++17 -O2 -DFIRE2_PROFILE shookpupil.cpp -o shookpupil -pthread
+#pragma once
+
+#include <cstdint>
+
+enum ProfileCounter {
+    PROF_BYTES_READ,        // bytes of input files mapped or read
+    PROF_ROWS_PARSED,       // CSV rows split into cells
+    PROF_PARSE_FAILURES,    // cells whose number did not parse and was left out
+    PROF_CACHE_LOADS,       // sessions loaded from their .cols sidecar
+    PROF_CACHE_BUILDS,      // sessions parsed from the CSV
+    NUM_PROFILE_COUNTERS
+};
+
+#ifdef FIRE2_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Profiler {
+public:
+    struct Event {
+        const char* stage;
+        std::string file;       // empty for plain scopes
+        int thread;
+        int64_t start, duration;   // ns since the profiler started
+    };
+
+    static Profiler& instance() {
+        static Profiler p;
+        return p;
+    }
+
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+    }
+    static int threadId() {
+        static std::atomic<int> next{0};
+        thread_local int id = next++;
+        return id;
+    }
+
+    void count(ProfileCounter c, uint64_t n) { counters_[c].fetch_add(n, std::memory_order_relaxed); }
+
+    void record(Event e) {
+        std::lock_guard<std::mutex> lock(m_);
+        Stage& s = stages_[e.stage];
+        s.count++;
+        s.total += e.duration;
+        if (e.duration > s.max) s.max = e.duration;
+        if (tracing_ || !e.file.empty()) events_.push_back(std::move(e));
+    }
+
+    ~Profiler() {
+        const char* name = std::getenv("FIRE2_PROFILE");
+        writeSummary(name && *name ? name : "profile.json");
+        if (tracing_) writeTrace(std::getenv("FIRE2_TRACE"));
+    }
+
+private:
+    struct Stage {
+        uint64_t count = 0;
+        int64_t total = 0, max = 0;
+    };
+
+    Profiler() : start_(std::chrono::steady_clock::now()) {
+        const char* trace = std::getenv("FIRE2_TRACE");
+        tracing_ = trace && *trace;
+    }
+
+    static std::string quoted(const std::string& s) {
+        std::string out = "\"";
+        for (unsigned char c : s) {
+            if (c == '"' || c == '\\') out += '\\', out += c;
+            else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof buf, "\\u%04x", c);
+                out += buf;
+            } else out += c;
+        }
+        return out + '"';
+    }
+
+    void writeSummary(const char* path) {
+        static const char* const names[NUM_PROFILE_COUNTERS] = {"bytesRead", "rowsParsed", "parseFailures",
+                                                               "cacheLoads", "cacheBuilds"};
+        FILE* f = fopen(path, "w");
+        if (!f) return;
+        std::lock_guard<std::mutex> lock(m_);
+        fprintf(f, "{\n  \"wallMs\": %.3f,\n  \"counters\": {", now() / 1e6);
+        for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+            fprintf(f, "%s\n    \"%s\": %llu", c ? "," : "", names[c], (unsigned long long)counters_[c].load());
+        fprintf(f, "\n  },\n  \"stages\": {");
+        bool first = true;
+        for (const auto& [stage, s] : stages_) {
+            fprintf(f, "%s\n    %s: {\"count\": %llu, \"totalMs\": %.3f, \"maxMs\": %.3f}", first ? "" : ",",
+                    quoted(stage).c_str(), (unsigned long long)s.count, s.total / 1e6, s.max / 1e6);
+            first = false;
+        }
+        fprintf(f, "\n  },\n  \"files\": [");
+        first = true;
+        for (const Event& e : events_) {
+            if (e.file.empty()) continue;
+            fprintf(f, "%s\n    {\"stage\": %s, \"file\": %s, \"ms\": %.3f}", first ? "" : ",", quoted(e.stage).c_str(),
+                    quoted(e.file).c_str(), e.duration / 1e6);
+            first = false;
+        }
+        fprintf(f, "\n  ]\n}\n");
+        fclose(f);
+    }
+
+    // Complete ("X") events in the Trace Event Format, timestamps in microseconds
+    void writeTrace(const char* path) {
+        FILE* f = fopen(path, "w");
+        if (!f) return;
+        std::lock_guard<std::mutex> lock(m_);
+        fprintf(f, "{\"traceEvents\": [");
+        for (size_t i = 0; i < events_.size(); i++) {
+            const Event& e = events_[i];
+            fprintf(f, "%s\n{\"name\": %s, \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+                    i ? "," : "", quoted(e.stage).c_str(), e.thread, e.start / 1e3, e.duration / 1e3);
+            if (!e.file.empty()) fprintf(f, ", \"args\": {\"file\": %s}", quoted(e.file).c_str());
+            fprintf(f, "}");
+        }
+        fprintf(f, "\n], \"displayTimeUnit\": \"ms\"}\n");
+        fclose(f);
+    }
+
+    std::chrono::steady_clock::time_point start_;
+    bool tracing_;
+    std::atomic<uint64_t> counters_[NUM_PROFILE_COUNTERS] = {};
+    std::mutex m_;
+    std::map<std::string, Stage> stages_;
+    std::vector<Event> events_;
+};
+
+// Start the clock during static initialisation, so wallMs covers the whole run
+inline Profiler& kProfilerStarted = Profiler::instance();
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* stage, std::string file = std::string())
+        : stage_(stage), file_(std::move(file)), start_(Profiler::instance().now()) {}
+    ~ProfileScope() {
+        Profiler& p = Profiler::instance();
+        p.record({stage_, std::move(file_), Profiler::threadId(), start_, p.now() - start_});
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* stage_;
+    std::string file_;
+    int64_t start_;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(stage)
+#define PROFILE_FILE(stage, path) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(stage, std::string(path))
+#define PROFILE_COUNT(counter, n) Profiler::instance().count(counter, (n))
+
+#else
+
+#define PROFILE_SCOPE(stage) ((void)0)
+#define PROFILE_FILE(stage, path) ((void)0)
+#define PROFILE_COUNT(counter, n) ((void)sizeof(n))
+
+#endif
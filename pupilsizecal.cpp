@@ -7,9 +7,14 @@
 #include <limits>
 #include <iomanip>
 #include <cmath>
+#include <cerrno>
+#include <cstdlib>
 #include <algorithm>
 #include <set>
 #include <utility>
+#include "parallel.h"
+#include "resultsink.h"
+#include "stats.h"
 
 using namespace std;
 namespace fs = filesystem;
@@ -22,107 +27,72 @@ typedef pair<ll, ll> pll;
 #define Y second
 const ll INF = 0x3f3f3f3f3f3f3f3f;
 
-// Function to trim whitespace from a string
-string trim(const string& str) {
-    string trimmed = str;
-    trimmed.erase(trimmed.begin(), find_if(trimmed.begin(), trimmed.end(), [](unsigned char ch) {
-        return !isspace(ch);
-    }));
-    trimmed.erase(find_if(trimmed.rbegin(), trimmed.rend(), [](unsigned char ch) {
-        return !isspace(ch);
-    }).base(), trimmed.end());
-    return trimmed;
-}
-
-// Function to check if a file has a .csv extension
-bool isCSVFile(const fs::path& filePath) {
-    return filePath.extension() == ".csv";
-}
-
-// Function to load CSV file into a 2D vector
-vector<vector<string>> loadCSV(const string& filePath) {
-    vector<vector<string>> data;
-    ifstream file(filePath);
-    if (!file.is_open()) {
-        cerr << "Error: Could not open " << filePath << endl;
-        return {};
-    }
-    string line;
-    while (getline(file, line)) {
-        stringstream ss(line);
-        vector<string> row;
-        string cell;
-        while (getline(ss, cell, ',')) {
-            row.pub(cell);
-        }
-        data.pub(row);
-    }
-    file.close();
-    return data;
-}
-
-// Function to find the columns that contain "leftPupil" and "rightPupil"
-pair<int, int> findPupilColumns(const vector<string>& headerRow) {
-    int leftPupilCol = -1, rightPupilCol = -1;
-    for (size_t i = 0; i < headerRow.size(); i++) {
-        string trimmedCell = trim(headerRow[i]);
-        if (trimmedCell.find("leftPupil") != string::npos) {
-            leftPupilCol = i;
-        }
-        if (trimmedCell.find("rightPupil") != string::npos) {
-            rightPupilCol = i;
-        }
+void computeAndPrintStats(const string& label, const SummaryStats &summary) {
+    const RunningStats& stats = summary.stats;
+    if (stats.empty()) {
+        cout << label << ": No valid data." << endl;
+        return;
     }
-    return {leftPupilCol, rightPupilCol};
+    cout << label << endl;
+    cout << "  Average: " << stats.mean() << endl;
+    cout << "  Variance: " << stats.variance() << endl;
+    cout << "  Min: " << stats.min() << ", Max: " << stats.max() << endl;
+    string quantiles = quantileSummary(summary);
+    if (!quantiles.empty()) cout << "  " << quantiles << endl;
 }
 
-// Function to find the row index that contains the "0.2 seconds" tag
-int findEventRow(const vector<vector<string>>& data) {
-    for (size_t i = 1; i < data.size(); i++) { // skip header
-        for (const string& cell : data[i]) {
-            if (cell.find("0.2 seconds") != string::npos) {
-                return i;  // Return the first occurrence
-            }
-        }
-    }
-    return -1;  // Not found
+// "left right" at the start of a line, as `ss >> left >> right` read it
+bool parsePair(const char* p, double& left, double& right) {
+    char* end;
+    errno = 0;
+    left = strtod(p, &end);
+    if (end == p || errno == ERANGE || !isfinite(left)) return false;
+    p = end;
+    right = strtod(p, &end);
+    return end != p && errno != ERANGE && isfinite(right);
 }
 
-// Structure to hold statistical information
-struct Stats {
-    double sum = 0.0;
-    double sumSq = 0.0;
-    int count = 0;
-    double minVal = numeric_limits<double>::max();
-    double maxVal = numeric_limits<double>::lowest();
+// Stats of one pupil size file, split at the empty line into before and after.
+// Invalid (-1) values are left out.
+struct PupilFile {
+    ostringstream log, err;
+    SummaryStats leftBefore, rightBefore, leftAfter, rightAfter;
 };
 
-void updateStats(Stats &stats, double value) {
-    // Ignore invalid data points (-1)
-    if (value == -1) return;
-    stats.sum += value;
-    stats.sumSq += value * value;
-    stats.count++;
-    stats.minVal = min(stats.minVal, value);
-    stats.maxVal = max(stats.maxVal, value);
-}
+PupilFile readPupilFile(const fs::path& path, QuantileMode quantiles) {
+    PupilFile res;
+    res.leftBefore = res.rightBefore = res.leftAfter = res.rightAfter = SummaryStats(quantiles);
+    ifstream inFile(path);
+    if (!inFile) {
+        res.err << "Error: Could not open file " << path << endl;
+        return res;
+    }
+    res.log << "Processing file: " << path.filename().string() << endl;
 
-void computeAndPrintStats(const string& label, const Stats &stats) {
-    if (stats.count == 0) {
-        cout << label << ": No valid data." << endl;
-        return;
+    string line;
+    bool isAfterSection = false;
+    while (getline(inFile, line)) {
+        if (line.find_first_not_of(" \t\r\n") == string::npos) {
+            // Empty line separates before and after sections.
+            isAfterSection = true;
+            continue;
+        }
+        // Two numbers, parsed in place (one line buffer for the whole file)
+        double leftVal, rightVal;
+        if (!parsePair(line.c_str(), leftVal, rightVal)) continue;
+        if (leftVal != -1) (isAfterSection ? res.leftAfter : res.leftBefore).add(leftVal);
+        if (rightVal != -1) (isAfterSection ? res.rightAfter : res.rightBefore).add(rightVal);
     }
-    double avg = stats.sum / stats.count;
-    double variance = (stats.count > 1) ? ((stats.sumSq - (stats.sum * stats.sum) / stats.count) / (stats.count - 1)) : 0.0;
-    cout << label << endl;
-    cout << "  Average: " << avg << endl;
-    cout << "  Variance: " << variance << endl;
-    cout << "  Min: " << stats.minVal << ", Max: " << stats.maxVal << endl;
+    return res;
 }
 
-int main() {
+int main(int argc, char** argv) {
     ios_base::sync_with_stdio(0);
     cin.tie(0);
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
+    // --quantiles / --exact-quantiles: also report median and IQR
+    QuantileMode quantiles = parseQuantileMode(argc, argv);
 
     // Folder paths for the pupil size files (extracted previously)
     fs::path pupilFolder = fs::path(".") / "pupil size";
@@ -132,72 +102,26 @@ int main() {
     }
 
     // Global aggregated stats for every data point (across all indices)
-    Stats globalLeftBefore, globalRightBefore, globalLeftAfter, globalRightAfter;
+    SummaryStats globalLeftBefore(quantiles), globalRightBefore(quantiles), globalLeftAfter(quantiles), globalRightAfter(quantiles);
     // Per person average stats (each file's average becomes one data point)
-    Stats personLeftBefore, personRightBefore, personLeftAfter, personRightAfter;
-
-    // Process each text file in the pupil size folder.
-    for (const auto& entry : fs::directory_iterator(pupilFolder)) {
-        if (fs::is_regular_file(entry.path()) && entry.path().extension() == ".txt") {
-            ifstream inFile(entry.path());
-            if (!inFile) {
-                cerr << "Error: Could not open file " << entry.path() << endl;
-                continue;
-            }
-            cout << "Processing file: " << entry.path().filename().string() << endl;
-
-            // Vectors to hold data points for this person
-            vector<double> fileLeftBefore, fileRightBefore, fileLeftAfter, fileRightAfter;
-            
-            string line;
-            bool isAfterSection = false;
-            while (getline(inFile, line)) {
-                if (line.find_first_not_of(" \t\r\n") == string::npos) {
-                    // Empty line separates before and after sections.
-                    isAfterSection = true;
-                    continue;
-                }
-                stringstream ss(line);
-                double leftVal, rightVal;
-                if (!(ss >> leftVal >> rightVal)) continue;
-                
-                // Update global stats if valid (ignoring -1)
-                if (!isAfterSection) {
-                    if (leftVal != -1) updateStats(globalLeftBefore, leftVal);
-                    if (rightVal != -1) updateStats(globalRightBefore, rightVal);
-                    fileLeftBefore.push_back(leftVal);
-                    fileRightBefore.push_back(rightVal);
-                } else {
-                    if (leftVal != -1) updateStats(globalLeftAfter, leftVal);
-                    if (rightVal != -1) updateStats(globalRightAfter, rightVal);
-                    fileLeftAfter.push_back(leftVal);
-                    fileRightAfter.push_back(rightVal);
-                }
-            }
-            inFile.close();
-
-            // Compute per-person averages for before and after windows.
-            // Only include if there is at least one valid data point.
-            auto computeFileAvg = [](const vector<double>& vals) -> double {
-                double sum = 0.0;
-                int count = 0;
-                for (double v : vals) {
-                    if (v != -1) { sum += v; count++; }
-                }
-                return (count > 0) ? (sum / count) : -1;
-            };
-
-            double fileLeftBeforeAvg = computeFileAvg(fileLeftBefore);
-            double fileRightBeforeAvg = computeFileAvg(fileRightBefore);
-            double fileLeftAfterAvg = computeFileAvg(fileLeftAfter);
-            double fileRightAfterAvg = computeFileAvg(fileRightAfter);
-
-            // Only update per-person stats if the average is valid (not -1)
-            if (fileLeftBeforeAvg != -1) updateStats(personLeftBefore, fileLeftBeforeAvg);
-            if (fileRightBeforeAvg != -1) updateStats(personRightBefore, fileRightBeforeAvg);
-            if (fileLeftAfterAvg != -1) updateStats(personLeftAfter, fileLeftAfterAvg);
-            if (fileRightAfterAvg != -1) updateStats(personRightAfter, fileRightAfterAvg);
-        }
+    SummaryStats personLeftBefore(quantiles), personRightBefore(quantiles), personLeftAfter(quantiles), personRightAfter(quantiles);
+
+    // Files are read in parallel; their stats are merged in index order.
+    vector<fs::path> files = indexedFiles(pupilFolder, ".txt");
+    vector<PupilFile> results = parallelMap<PupilFile>(files.size(), threads, [&](size_t k) { return readPupilFile(files[k], quantiles); });
+    for (const PupilFile& res : results) {
+        cerr << res.err.str();
+        printProgress(cout, res.log.str(), quiet);
+        globalLeftBefore.merge(res.leftBefore);
+        globalRightBefore.merge(res.rightBefore);
+        globalLeftAfter.merge(res.leftAfter);
+        globalRightAfter.merge(res.rightAfter);
+
+        // Per-person averages, only for windows with at least one valid data point
+        if (!res.leftBefore.stats.empty()) personLeftBefore.add(res.leftBefore.stats.mean());
+        if (!res.rightBefore.stats.empty()) personRightBefore.add(res.rightBefore.stats.mean());
+        if (!res.leftAfter.stats.empty()) personLeftAfter.add(res.leftAfter.stats.mean());
+        if (!res.rightAfter.stats.empty()) personRightAfter.add(res.rightAfter.stats.mean());
     }
 
     // Print aggregated statistics across all data points.
@@ -0,0 +1,58 @@
+// Readers for the pupil result tables.
+// leftpupil.txt / rightpupil.txt (written by the window tools, see kPupilColumns in
+// windowengine.h) hold one row per index:
+//   index luminanceBefore pupilBefore nBefore sdBefore luminanceAfter pupilAfter nAfter sdAfter
+// readPupilTable() loads both halves of every row at once, so the statistics tools do
+// not need a before and an after copy of the same parser.
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// One window of one row: the same fields as a calibration entry
+struct PupilSummary {
+    double luminance;
+    double avgSize;
+    int count;
+    double stdDev;
+};
+
+enum PupilHalf { BEFORE_EVENT, AFTER_EVENT };
+
+struct PupilRow {
+    std::string index;
+    PupilSummary half[2];     // [BEFORE_EVENT], [AFTER_EVENT]
+};
+
+// Rows sorted by index; a repeated index keeps its last row, as the std::map the
+// t-tests filled did. Empty (with the reason on cerr) when the file cannot be read.
+inline std::vector<PupilRow> readPupilTable(const std::string& filename) {
+    std::vector<PupilRow> rows;
+    std::ifstream inFile(filename);
+    if (!inFile) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return rows;
+    }
+    PupilRow r;
+    double nBefore, nAfter;
+    PupilSummary &b = r.half[BEFORE_EVENT], &a = r.half[AFTER_EVENT];
+    while (inFile >> r.index >> b.luminance >> b.avgSize >> nBefore >> b.stdDev >> a.luminance >> a.avgSize >> nAfter >> a.stdDev) {
+        b.count = (int)nBefore;
+        a.count = (int)nAfter;
+        rows.push_back(r);
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const PupilRow& x, const PupilRow& y) { return x.index < y.index; });
+    std::vector<PupilRow> unique;
+    for (size_t i = 0; i < rows.size(); i++)
+        if (i + 1 == rows.size() || rows[i + 1].index != rows[i].index) unique.push_back(rows[i]);
+    return unique;
+}
+
+// Row of index in a table from readPupilTable(), nullptr when absent
+inline const PupilRow* findPupilRow(const std::vector<PupilRow>& rows, const std::string& index) {
+    auto it = std::lower_bound(rows.begin(), rows.end(), index, [](const PupilRow& r, const std::string& i) { return r.index < i; });
+    return it != rows.end() && it->index == index ? &*it : nullptr;
+}
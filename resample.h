@@ -0,0 +1,142 @@
+// Resampling inference for group comparisons (shook vs noshook, ...).
+// A permutation test and a percentile bootstrap of the difference in group means,
+// meant for 10^5 and more resamples. The two groups live in one contiguous array
+// (group A first), and a resample only ever touches a private copy of it.
+//
+// Random numbers come from a counter-based generator: resample r draws from the stream
+// keyed by (seed, r), so the sequence of every resample is fixed by the seed alone.
+// Resamples are handed out in blocks on the parallel.h pool and block results are
+// combined in block order, so results are identical for any thread count.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include "parallel.h"
+
+// Stateless SplitMix64-style generator: output k of stream (seed, stream) is a hash of
+// k, so streams need no state beyond a counter and never overlap in practice
+class CounterRng {
+public:
+    CounterRng(uint64_t seed, uint64_t stream) : key_(mix(seed ^ mix(stream + 0x9e3779b97f4a7c15ULL))) {}
+
+    uint64_t next() { return mix(key_ + 0x9e3779b97f4a7c15ULL * ++counter_); }
+    // Uniform double in [lo, hi)
+    double uniform(double lo = 0.0, double hi = 1.0) { return lo + (hi - lo) * double(next() >> 11) * 0x1.0p-53; }
+    // Uniform integer in [0, n), Lemire's multiply-and-reject
+    uint64_t below(uint64_t n) {
+        unsigned __int128 m = (unsigned __int128)next() * n;
+        uint64_t low = (uint64_t)m;
+        if (low < n) {
+            uint64_t threshold = -n % n;
+            while (low < threshold) {
+                m = (unsigned __int128)next() * n;
+                low = (uint64_t)m;
+            }
+        }
+        return m >> 64;
+    }
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t key_;
+    uint64_t counter_ = 0;
+};
+
+struct PermutationResult {
+    double observed = NAN;   // mean(A) - mean(B)
+    double p = NAN;          // two-sided, (extreme + 1) / (resamples + 1)
+    size_t resamples = 0;
+};
+
+struct BootstrapResult {
+    double estimate = NAN;   // mean(A) - mean(B)
+    double low = NAN, high = NAN;
+    double level = 0;
+    size_t resamples = 0;
+};
+
+inline double meanOf(const double* v, size_t n) {
+    return n ? std::accumulate(v, v + n, 0.0) / n : NAN;
+}
+
+// Two-sided permutation test of the difference in means. Each resample draws group A
+// by a partial Fisher-Yates shuffle of the pooled values; only the sums are needed.
+inline PermutationResult permutationTest(const std::vector<double>& a, const std::vector<double>& b, size_t resamples,
+                                         uint64_t seed, int threads) {
+    PermutationResult res;
+    size_t na = a.size(), n = a.size() + b.size();
+    if (a.empty() || b.empty()) return res;
+    std::vector<double> pooled(a);
+    pooled.insert(pooled.end(), b.begin(), b.end());
+    double total = std::accumulate(pooled.begin(), pooled.end(), 0.0);
+    res.observed = meanOf(a.data(), na) - meanOf(b.data(), b.size());
+    res.resamples = resamples;
+    // Tolerance so that resamples equal to the observed split count as extreme
+    double bound = std::fabs(res.observed) * (1 - 1e-12);
+
+    const size_t kBlock = 1024;
+    size_t blocks = (resamples + kBlock - 1) / kBlock;
+    std::vector<size_t> extreme(blocks, 0);
+    parallelFor(blocks, threads, [&](size_t blk) {
+        std::vector<double> v(pooled);
+        size_t end = std::min(resamples, (blk + 1) * kBlock);
+        for (size_t r = blk * kBlock; r < end; r++) {
+            CounterRng rng(seed, r);
+            double sumA = 0;
+            for (size_t i = 0; i < na; i++) {
+                std::swap(v[i], v[i + rng.below(n - i)]);
+                sumA += v[i];
+            }
+            double diff = sumA / na - (total - sumA) / (n - na);
+            if (std::fabs(diff) >= bound) extreme[blk]++;
+        }
+    });
+    size_t count = std::accumulate(extreme.begin(), extreme.end(), size_t(0));
+    res.p = double(count + 1) / double(resamples + 1);
+    return res;
+}
+
+// Percentile bootstrap interval of mean(A) - mean(B), both groups resampled with
+// replacement independently
+inline BootstrapResult bootstrapMeanDifference(const std::vector<double>& a, const std::vector<double>& b,
+                                               size_t resamples, double level, uint64_t seed, int threads) {
+    BootstrapResult res;
+    if (a.empty() || b.empty() || resamples == 0) return res;
+    res.estimate = meanOf(a.data(), a.size()) - meanOf(b.data(), b.size());
+    res.level = level;
+    res.resamples = resamples;
+
+    std::vector<double> stats(resamples);
+    const size_t kBlock = 1024;
+    size_t blocks = (resamples + kBlock - 1) / kBlock;
+    parallelFor(blocks, threads, [&](size_t blk) {
+        size_t end = std::min(resamples, (blk + 1) * kBlock);
+        for (size_t r = blk * kBlock; r < end; r++) {
+            // Streams above 2^63 keep bootstrap draws apart from the permutation ones
+            CounterRng rng(seed, r | (uint64_t(1) << 63));
+            double sa = 0, sb = 0;
+            for (size_t i = 0; i < a.size(); i++) sa += a[rng.below(a.size())];
+            for (size_t i = 0; i < b.size(); i++) sb += b[rng.below(b.size())];
+            stats[r] = sa / a.size() - sb / b.size();
+        }
+    });
+    std::sort(stats.begin(), stats.end());
+    // Quantiles interpolated between order statistics (numpy's default)
+    auto quantile = [&](double q) {
+        double pos = q * (resamples - 1);
+        size_t i = size_t(pos);
+        if (i + 1 >= resamples) return stats.back();
+        return stats[i] + (pos - i) * (stats[i + 1] - stats[i]);
+    };
+    res.low = quantile((1 - level) / 2);
+    res.high = quantile(1 - (1 - level) / 2);
+    return res;
+}
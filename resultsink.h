@@ -0,0 +1,150 @@
+// Where the batch tools' results go.
+// ResultTable keeps a result table (leftpupil.txt, rightpupil.txt, ...) in memory
+// while a run fills it and writes it once at the end: a single open, one buffered
+// write and an atomic rename, instead of an open/append/close per row. With --binary
+// the merged table is also written as <name>.bin: a small header, the column names and
+// the rows as little-endian float64, which numpy reads with one np.fromfile.
+//
+// --quiet drops the per-file progress lines from the console; error lines and the
+// summaries are still printed.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "manifest.h"
+
+struct SinkOptions {
+    bool quiet = false;
+    bool binary = false;
+};
+
+// --quiet and --binary from argv
+inline SinkOptions parseSinkOptions(int argc, char** argv) {
+    SinkOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quiet" || arg == "-q") opt.quiet = true;
+        if (arg == "--binary") opt.binary = true;
+    }
+    return opt;
+}
+
+// Print a block of per-file console lines; in quiet mode only its error lines
+inline void printProgress(std::ostream& os, const std::string& lines, bool quiet) {
+    if (!quiet) {
+        os << lines;
+        return;
+    }
+    size_t pos = 0;
+    while (pos < lines.size()) {
+        size_t nl = lines.find('\n', pos);
+        size_t end = nl == std::string::npos ? lines.size() : nl + 1;
+        if (lines.substr(pos, end - pos).find("ERROR") != std::string::npos)
+            os.write(lines.data() + pos, end - pos);
+        pos = end;
+    }
+}
+
+// Binary copy of a whitespace-separated numeric table:
+//   "F2TABLE1", uint32 columns, uint32 name bytes, uint64 rows,
+//   the column names joined by '\n', then rows x columns float64, row-major.
+// Cells that are not numbers are stored as NaN, missing cells as well.
+inline bool writeBinaryTable(const std::string& textFile, const std::string& binFile,
+                             const std::vector<std::string>& columns) {
+    std::ifstream in(textFile);
+    std::vector<double> cells;
+    uint64_t rows = 0;
+    std::string line;
+    while (getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::istringstream ss(line);
+        std::string cell;
+        size_t c = 0;
+        for (; c < columns.size() && ss >> cell; c++) {
+            char* end;
+            double v = strtod(cell.c_str(), &end);
+            cells.push_back(*end == '\0' ? v : NAN);
+        }
+        for (; c < columns.size(); c++) cells.push_back(NAN);
+        rows++;
+    }
+    std::string names;
+    for (size_t c = 0; c < columns.size(); c++) names += (c ? "\n" : "") + columns[c];
+
+    std::string tmp = binFile + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: Could not open file " << binFile << std::endl;
+            return false;
+        }
+        uint32_t ncols = columns.size(), nameBytes = names.size();
+        out.write("F2TABLE1", 8);
+        out.write(reinterpret_cast<const char*>(&ncols), sizeof(ncols));
+        out.write(reinterpret_cast<const char*>(&nameBytes), sizeof(nameBytes));
+        out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        out.write(names.data(), names.size());
+        out.write(reinterpret_cast<const char*>(cells.data()), cells.size() * sizeof(double));
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, binFile, ec);
+    if (ec) {
+        std::remove(tmp.c_str());
+        std::cerr << "Error: Could not open file " << binFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// A table of numeric rows keyed by their first field, merged into its file once.
+// Keys set or erased in this run replace their old rows (the last set or erase of a
+// key wins); other rows are kept.
+class ResultTable {
+public:
+    ResultTable(std::string filename, std::vector<std::string> columns)
+        : filename_(std::move(filename)), columns_(std::move(columns)) {}
+
+    // Row of key: key followed by values, in the default stream format
+    void set(const std::string& key, const std::vector<double>& values) {
+        std::ostringstream row;
+        row << key;
+        for (double v : values) row << ' ' << v;
+        put(key, row.str());
+    }
+    void erase(const std::string& key) { put(key, ""); }
+
+    const std::string& filename() const { return filename_; }
+
+    bool flush(const SinkOptions& opt) const {
+        if (!upsertRows(filename_, rows_)) return false;
+        if (!opt.binary || rows_.empty()) return true;
+        std::string bin = std::filesystem::path(filename_).replace_extension(".bin").string();
+        return writeBinaryTable(filename_, bin, columns_);
+    }
+
+private:
+    // Replaces a pending row of key in place, so keys keep the order they were first given
+    void put(const std::string& key, std::string row) {
+        auto it = pos_.find(key);
+        if (it != pos_.end()) {
+            rows_[it->second].second = std::move(row);
+            return;
+        }
+        pos_[key] = rows_.size();
+        rows_.push_back({key, std::move(row)});
+    }
+
+    std::string filename_;
+    std::vector<std::string> columns_;
+    std::vector<std::pair<std::string, std::string>> rows_;
+    std::map<std::string, size_t> pos_;   // index of each key's entry in rows_
+};
@@ -0,0 +1,156 @@
+// One-pass routing of raw session CSVs into the condition folders.
+// Applies the rules of shookfilter.cpp, noshook.cpp, intermediatefilter.cpp and
+// shooksurveyfilter.cpp together, reading each file once (in parallel, stopping as
+// soon as every tag it can still be routed by has been seen):
+//   "shook" anywhere in the file                       -> shook/
+//   else Standard_Office and not Tablet in the name     -> noshook/
+//   else intermediate and not tablet in the name        -> intermediate/
+//   shook/noshook files with "robot entered survey room" (any case) go on to survey/
+// Files already in shook/ and noshook/ are checked for the survey rule as well.
+// Moves never replace an existing file; keepSource hardlinks into the destination and
+// leaves the source in place, dryRun only reports what would happen.
+// routefilter.cpp and the route stage of pipeline.cpp are front ends for runRouting().
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+#include "csvreader.h"
+#include "eventlocator.h"
+#include "datasetindex.h"
+#include "parallel.h"
+
+enum ContentTag { TAG_SHOOK = 1, TAG_SURVEY = 2 };
+
+// Tags of the file, reading it line by line until every tag in `wanted` has been seen
+inline unsigned classifyContent(const std::filesystem::path& filePath, unsigned wanted) {
+    static const EventPatterns shook({"shook"});
+    static const EventPatterns survey({"robot entered survey room"}, true);
+    MappedFile file(filePath.string());
+    std::string_view text = file.text();
+    unsigned seen = 0;
+    size_t pos = 0;
+    while (pos < text.size() && (seen & wanted) != wanted) {
+        size_t nl = text.find('\n', pos);
+        std::string_view line = text.substr(pos, nl == std::string_view::npos ? std::string_view::npos : nl - pos);
+        if ((wanted & TAG_SHOOK) && shook.matches(line)) seen |= TAG_SHOOK;
+        if ((wanted & TAG_SURVEY) && survey.matches(line)) seen |= TAG_SURVEY;
+        pos = nl == std::string_view::npos ? text.size() : nl + 1;
+    }
+    return seen;
+}
+
+struct Route {
+    const DataFile* file;
+    DataFolder to;          // destination, or the file's own folder when it stays
+    std::string reason;
+};
+
+// Final folder of one file under all routing rules
+inline Route routeFile(const DataFile& file, const DatasetIndex& dataset) {
+    unsigned wanted = file.folder == ROOT_DIR ? TAG_SHOOK | TAG_SURVEY : TAG_SURVEY;
+    if (file.name.length() < 5) wanted &= ~TAG_SURVEY;   // shooksurveyfilter.cpp skipped these
+    unsigned tags = classifyContent(file.path(dataset.root()), wanted);
+
+    Route r{&file, file.folder, ""};
+    if (file.folder == ROOT_DIR) {
+        if (tags & TAG_SHOOK) r = {&file, SHOOK_DIR, "contains \"shook\""};
+        else if (file.kinds & KIND_STANDARD_OFFICE) r = {&file, NOSHOOK_DIR, "Standard_Office session"};
+        else if (file.kinds & KIND_INTERMEDIATE) r = {&file, INTERMEDIATE_DIR, "intermediate session"};
+    }
+    if ((r.to == SHOOK_DIR || r.to == NOSHOOK_DIR) && (tags & TAG_SURVEY)) {
+        r.reason += std::string(r.reason.empty() ? "" : ", ") + "reaches the survey room";
+        r.to = SURVEY_DIR;
+    }
+    return r;
+}
+
+// Move (or hardlink) without ever replacing an existing destination: link() fails with
+// EEXIST when it is taken, and the source is only unlinked once the link exists.
+inline bool placeFile(const std::filesystem::path& src, const std::filesystem::path& dst, bool keepSource,
+                      std::string& error) {
+    if (link(src.c_str(), dst.c_str()) == 0) {
+        if (!keepSource && unlink(src.c_str()) != 0) {
+            error = strerror(errno);
+            return false;
+        }
+        return true;
+    }
+    if (errno == EEXIST || keepSource) {
+        error = errno == EEXIST ? "destination exists" : strerror(errno);
+        return false;
+    }
+    // File systems without hard links: fall back to a checked rename
+    std::error_code ec;
+    if (std::filesystem::exists(dst, ec)) {
+        error = "destination exists";
+        return false;
+    }
+    std::filesystem::rename(src, dst, ec);
+    if (ec) {
+        error = ec.message();
+        return false;
+    }
+    return true;
+}
+
+struct RouteOptions {
+    int threads = 1;
+    bool dryRun = false;
+    bool keepSource = false;
+};
+
+// Route every CSV of the current directory, shook/ and noshook/, reporting each move
+// and the per-folder counts to out. Returns the number of files that could not be placed.
+inline int runRouting(const RouteOptions& opt, std::ostream& out) {
+    namespace fs = std::filesystem;
+    DatasetIndex dataset(".");
+    std::vector<const DataFile*> files;
+    for (DataFolder f : {ROOT_DIR, SHOOK_DIR, NOSHOOK_DIR})
+        for (const DataFile* file : dataset.files(f)) files.push_back(file);
+
+    out << "Classifying " << files.size() << " CSV files in the current directory, shook and noshook folders..." << std::endl;
+
+    std::vector<Route> routes =
+        parallelMap<Route>(files.size(), opt.threads, [&](size_t i) { return routeFile(*files[i], dataset); });
+
+    // Moves run serially in index order, so the report is the same for any thread count
+    std::map<DataFolder, int> counts;
+    int failed = 0;
+    for (const Route& r : routes) {
+        if (r.to == r.file->folder) continue;
+        fs::path src = r.file->path(dataset.root());
+        fs::path dst = fs::path(kDataFolderNames[r.to]) / r.file->name;
+        std::string from =
+            r.file->folder == ROOT_DIR ? r.file->name : std::string(kDataFolderNames[r.file->folder]) + "/" + r.file->name;
+        if (opt.dryRun) {
+            out << "Would " << (opt.keepSource ? "link" : "move") << ": " << from << " -> '" << kDataFolderNames[r.to]
+                << "' (" << r.reason << ")\n";
+            counts[r.to]++;
+            continue;
+        }
+        std::error_code ec;
+        fs::create_directories(kDataFolderNames[r.to], ec);
+        std::string error;
+        if (placeFile(src, dst, opt.keepSource, error)) {
+            out << (opt.keepSource ? "Linked: " : "Moved: ") << from << " -> '" << kDataFolderNames[r.to] << "' ("
+                << r.reason << ")\n";
+            counts[r.to]++;
+        } else {
+            out << "Skipping: " << from << " (" << error << ")\n";
+            failed++;
+        }
+    }
+
+    out << "\n==== Routing Report" << (opt.dryRun ? " (dry run)" : "") << " ====\n";
+    for (DataFolder f : {SHOOK_DIR, NOSHOOK_DIR, INTERMEDIATE_DIR, SURVEY_DIR})
+        out << kDataFolderNames[f] << ": " << counts[f] << '\n';
+    out << "Skipped: " << failed << '\n';
+    return failed;
+}
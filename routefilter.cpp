@@ -0,0 +1,29 @@
+// One-pass router for a batch of raw session CSVs (the rules are in routeengine.h).
+// Replaces shookfilter.cpp, noshook.cpp, intermediatefilter.cpp and
+// shooksurveyfilter.cpp, reading each file once. Moves never replace an existing
+// file; --link hardlinks into the destination and leaves the source in place,
+// --dry-run only prints what would happen.
+//g++ -std=c++17 -O2 routefilter.cpp -o routefilter -pthread
+//usage: ./routefilter [-j threads] [--dry-run] [--link]
+#include <iostream>
+#include <string>
+#include "routeengine.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    RouteOptions opt;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--dry-run" || arg == "-n") opt.dryRun = true;
+        if (arg == "--link") opt.keepSource = true;
+    }
+    opt.threads = parseThreads(argc, argv);
+
+    runRouting(opt, cout);
+    cout << "\nProcessing complete." << endl;
+    return 0;
+}
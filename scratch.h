@@ -0,0 +1,53 @@
+// Per-thread reusable buffers for per-file work.
+// Processing a session needs a few large vectors (cell views, parsed columns, the
+// window samples, forward-filled positions, ...) whose sizes are about the same from
+// one file to the next. Allocating and freeing them for every file made the workers of
+// parallel.h meet in the allocator. A Scratch<T> instead borrows a vector from a small
+// free list of the calling thread, cleared but with its capacity, and gives it back
+// when it goes out of scope, so after the first file a worker runs on the same memory.
+// A Scratch may be destroyed on another thread; its vector then joins that thread's list.
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+template <class T>
+class Scratch {
+public:
+    Scratch() {
+        std::vector<std::vector<T>>& free = pool();
+        if (!free.empty()) {
+            v_ = std::move(free.back());
+            free.pop_back();
+        }
+    }
+    ~Scratch() {
+        std::vector<std::vector<T>>& free = pool();
+        if (v_.capacity() == 0 || free.size() >= kKeep) return;
+        v_.clear();
+        free.push_back(std::move(v_));
+    }
+    Scratch(Scratch&& o) noexcept { v_.swap(o.v_); }
+    Scratch& operator=(Scratch&& o) noexcept {
+        v_.swap(o.v_);
+        return *this;
+    }
+    Scratch(const Scratch&) = delete;
+    Scratch& operator=(const Scratch&) = delete;
+
+    std::vector<T>& operator*() { return v_; }
+    const std::vector<T>& operator*() const { return v_; }
+    std::vector<T>* operator->() { return &v_; }
+    const std::vector<T>* operator->() const { return &v_; }
+
+private:
+    // Buffers kept per thread and element type; a file borrows at most a few at a time
+    static constexpr size_t kKeep = 8;
+    static std::vector<std::vector<T>>& pool() {
+        thread_local std::vector<std::vector<T>> free;
+        return free;
+    }
+
+    std::vector<T> v_;
+};
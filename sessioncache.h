@@ -0,0 +1,315 @@
+// Columnar cache of a parsed session CSV.
+// The first time a session is opened its time, pupil, luminance, position and gaze
+// columns are parsed once into contiguous float64 arrays, the robotEvent, roomEvent and
+// LookingAt cells are interned into a string table, and the result is written next to the CSV as
+// <file>.csv.cols. Later runs mmap that sidecar and skip parsing entirely. The sidecar
+// records the CSV's size and mtime and is rebuilt as soon as either changes.
+//
+// Cells that do not parse (or are missing from a short row) are stored as NaN.
+// Time, pupil and luminance use the stod rules of the pupil tools, positions and gaze
+// use the strict whole-cell rule of speed.cpp. cellCount keeps each row's cell count so tools
+// can keep their "row too short" checks.
+//
+// The session's event timeline (eventtimeline.h) is built on the same pass and kept
+// as <file>.csv.events; event lookups read it instead of the rows.
+// The build arrays and the in-memory layout come from the thread's scratch buffers
+// (scratch.h) and go back to them with the session.
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+#include "csvreader.h"
+#include "eventlocator.h"
+#include "eventtimeline.h"
+#include "scratch.h"
+#include "sessionschema.h"
+
+class SessionColumns {
+public:
+    explicit SessionColumns(const std::string& csvPath) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        srcSize_ = fs::file_size(csvPath, ec);
+        if (ec) {
+            std::cerr << "Error: Could not open " << csvPath << std::endl;
+            return;
+        }
+        srcMtime_ = fs::last_write_time(csvPath, ec).time_since_epoch().count();
+        std::string cachePath = csvPath + ".cols", timelinePath = csvPath + ".events";
+        if (loadCache(cachePath)) {
+            PROFILE_COUNT(PROF_CACHE_LOADS, 1);
+            PROFILE_COUNT(PROF_BYTES_READ, mapLen_);
+            if (!timeline_.load(timelinePath, srcSize_, srcMtime_)) {
+                // Sidecar from before timelines were kept
+                PROFILE_FILE("timeline build", std::filesystem::path(csvPath).filename().string());
+                CSVFile data(csvPath);
+                timeline_ = EventTimeline::fromCSV(data, values(COL_TIME), column(COL_LOOKING_AT));
+                timeline_.save(timelinePath, srcSize_, srcMtime_);
+            }
+        } else {
+            PROFILE_FILE("column build", std::filesystem::path(csvPath).filename().string());
+            PROFILE_COUNT(PROF_CACHE_BUILDS, 1);
+            // No sidecars for a file that was not read in full: a later run (or a build
+            // with its codec) must read it again rather than trust an empty cache
+            if (build(csvPath)) {
+                writeCache(cachePath);
+                timeline_.save(timelinePath, srcSize_, srcMtime_);
+            }
+        }
+    }
+    ~SessionColumns() {
+        if (map_) munmap(map_, mapLen_);
+    }
+    SessionColumns(const SessionColumns&) = delete;
+    SessionColumns& operator=(const SessionColumns&) = delete;
+
+    // True when the CSV could not be read or had no lines at all
+    bool empty() const { return base_ == nullptr || !header().hasHeader; }
+    bool fromCache() const { return map_ != nullptr; }
+    // Data rows, header excluded: row r here is line r + 1 of the CSV
+    size_t rows() const { return base_ ? header().rows : 0; }
+    // Column index in the CSV header, -1 if the file has no such column
+    int column(SessionField f) const { return base_ ? header().cols[f] : -1; }
+    // How the header matched kSessionSchema (sessionschema.h): fields no header cell
+    // matched, fields several matched (bit f for SessionField f), and whether luminance
+    // was taken from before leftPupil for want of its own header
+    uint32_t missingFields() const { return base_ ? header().missing : (1u << NUM_FIELDS) - 1; }
+    uint32_t ambiguousFields() const { return base_ ? header().ambiguous : 0; }
+    bool luminanceInferred() const { return base_ && header().luminanceInferred; }
+    const double* values(SessionField f) const {
+        return reinterpret_cast<const double*>(base_ + numOff()) + f * rows();
+    }
+    const uint32_t* cellCounts() const {
+        return reinterpret_cast<const uint32_t*>(base_ + u32Off());
+    }
+    // Interned ids of a text field (COL_ROBOT_EVENT, COL_ROOM_EVENT, COL_LOOKING_AT),
+    // 0 is the empty string
+    const uint32_t* events(SessionField f) const {
+        return cellCounts() + (f - NUM_NUMERIC + 1) * rows();
+    }
+    size_t stringCount() const { return base_ ? header().stringCount : 0; }
+    std::string_view str(uint32_t id) const {
+        const uint64_t* off = reinterpret_cast<const uint64_t*>(base_ + strOff());
+        const char* bytes = base_ + bytesOff();
+        return std::string_view(bytes + off[id], off[id + 1] - off[id]);
+    }
+    // Every text cell of the session, in file order
+    const EventTimeline& timeline() const { return timeline_; }
+
+    // First data row whose event cell satisfies pred, -1 if none. Empty cells never
+    // match.
+    template <class Pred>
+    int findEventIf(SessionField f, Pred pred) const {
+        int c = column(f);
+        return c < 0 ? -1 : timeline_.findIf(c, pred);
+    }
+    int findEvent(SessionField f, std::string_view needle) const {
+        return findEventIf(f, [&](std::string_view s) { return s.find(needle) != std::string_view::npos; });
+    }
+    // First data row of every pattern in one pass over the event column; hits carry the
+    // row's time. Rows where accept(row) is false are passed over. Stops once all are found.
+    template <class Accept>
+    std::vector<EventHit> findEvents(SessionField f, const EventPatterns& patterns, Accept accept) const {
+        int c = column(f);
+        if (c < 0) return std::vector<EventHit>(patterns.size());
+        return timeline_.find(patterns, c, accept);
+    }
+    std::vector<EventHit> findEvents(SessionField f, const EventPatterns& patterns) const {
+        return findEvents(f, patterns, [](size_t) { return true; });
+    }
+
+private:
+    struct Header {
+        char magic[8];
+        uint64_t srcSize;
+        int64_t srcMtime;
+        uint64_t rows;
+        uint64_t stringCount;
+        uint64_t stringBytes;
+        int32_t cols[NUM_FIELDS];
+        int32_t hasHeader;
+        uint32_t missing;
+        uint32_t ambiguous;
+        int32_t luminanceInferred;
+    };
+    static constexpr char kMagic[8] = {'F', '2', 'C', 'O', 'L', 'S', '0', '3'};
+
+    static size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+    const Header& header() const { return *reinterpret_cast<const Header*>(base_); }
+    static size_t numOff() { return align8(sizeof(Header)); }
+    size_t u32Off() const { return numOff() + NUM_NUMERIC * rows() * sizeof(double); }
+    size_t strOff() const { return align8(u32Off() + (1 + NUM_TEXT) * rows() * sizeof(uint32_t)); }
+    size_t bytesOff() const { return strOff() + (stringCount() + 1) * sizeof(uint64_t); }
+    size_t totalSize() const { return bytesOff() + header().stringBytes; }
+
+    bool loadCache(const std::string& cachePath) {
+        int fd = open(cachePath.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header);
+        if (ok) {
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = p != MAP_FAILED;
+            if (ok) {
+                map_ = static_cast<char*>(p);
+                mapLen_ = st.st_size;
+                base_ = map_;
+            }
+        }
+        close(fd);
+        if (!ok) return false;
+        const Header& h = header();
+        if (memcmp(h.magic, kMagic, 8) != 0 || h.srcSize != srcSize_ || h.srcMtime != srcMtime_ ||
+            totalSize() != mapLen_) {
+            munmap(map_, mapLen_);
+            map_ = nullptr;
+            base_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // One pass over the lines: the header is resolved against the schema, then every
+    // cell is looked up in the column plan. Cells no field reads are only checked for
+    // the timeline; no row is split into a cell array. False when the file could not be
+    // read in full (see MappedFile::readable); the session is then empty.
+    bool build(const std::string& csvPath) {
+        static_assert(fieldSpec(COL_TIME).position == 0, "the row time must be parsed before its other cells");
+        MappedFile file(csvPath);
+        Header h{};
+        memcpy(h.magic, kMagic, 8);
+        h.srcSize = srcSize_;
+        h.srcMtime = srcMtime_;
+        std::fill(std::begin(h.cols), std::end(h.cols), -1);
+        h.missing = (1u << NUM_FIELDS) - 1;
+
+        Scratch<double> numBuf;   // NUM_NUMERIC values per row, row after row
+        std::vector<double>& num = *numBuf;
+        Scratch<uint32_t> u32[1 + NUM_TEXT];   // cell counts, then the ids of each text field
+        Scratch<std::string_view> stringBuf, headerBuf;
+        std::vector<std::string_view>& strings = *stringBuf;
+        strings.push_back(std::string_view());
+        // Kept per thread so its buckets are reused; the keys point into this file only
+        thread_local std::unordered_map<std::string_view, uint32_t> ids;
+        ids.clear();
+        ids.emplace(std::string_view(), 0);
+        ColumnPlan plan;
+        std::vector<char> eventCol;
+
+        size_t failures = 0;
+        bool ok = forEachLine(file, [&](std::string_view line) {
+            if (!h.hasHeader) {
+                h.hasHeader = 1;
+                forEachCell(line, [&](size_t, std::string_view cell) { headerBuf->push_back(cell); });
+                CSVRow headerRow(headerBuf->data(), headerBuf->size());
+                SchemaResolution schema = resolveSchema(headerRow);
+                std::copy(std::begin(schema.cols), std::end(schema.cols), h.cols);
+                h.missing = schema.missing;
+                h.ambiguous = schema.ambiguous;
+                h.luminanceInferred = schema.luminanceInferred;
+                plan = ColumnPlan(h.cols);
+                for (std::string_view cell : headerRow) eventCol.push_back(EventTimeline::isEventHeader(cell));
+                return;
+            }
+            uint32_t r = h.rows++;
+            num.insert(num.end(), NUM_NUMERIC, NAN);
+            double* numRow = num.data() + (size_t)r * NUM_NUMERIC;
+            for (int k = 1; k <= NUM_TEXT; k++) u32[k]->push_back(0);
+            size_t n = forEachCell(line, [&](size_t c, std::string_view cell) {
+                for (uint32_t fields = plan.fields(c); fields; fields &= fields - 1) {
+                    int f = __builtin_ctz(fields);
+                    switch (fieldSpec(SessionField(f)).parse) {
+                        case CellParse::STRICT: {
+                            double v;
+                            if (parseDouble(cell, v)) numRow[f] = v;
+                            else failures++;
+                            break;
+                        }
+                        case CellParse::STOD:
+                            try { numRow[f] = toDouble(cell); } catch (...) { failures++; }
+                            break;
+                        case CellParse::TEXT: {
+                            auto it = ids.try_emplace(cell, (uint32_t)strings.size());
+                            if (it.second) strings.push_back(cell);
+                            (*u32[f - NUM_NUMERIC + 1])[r] = it.first->second;
+                            break;
+                        }
+                    }
+                }
+                if ((int)c != h.cols[COL_LOOKING_AT] && EventTimeline::keeps(c < eventCol.size() && eventCol[c], cell))
+                    timeline_.add(r, c, numRow[COL_TIME], cell);
+            });
+            u32[0]->push_back(n);
+        });
+        PROFILE_COUNT(PROF_ROWS_PARSED, h.hasHeader + h.rows);
+        if (!ok) {   // no half-parsed sessions
+            h.hasHeader = 0;
+            h.rows = 0;
+            std::fill(std::begin(h.cols), std::end(h.cols), -1);
+            h.missing = (1u << NUM_FIELDS) - 1;
+            h.ambiguous = h.luminanceInferred = 0;
+            strings.resize(1);
+            timeline_ = EventTimeline();
+        }
+
+        PROFILE_COUNT(PROF_PARSE_FAILURES, failures);
+        h.stringCount = strings.size();
+        for (auto s : strings) h.stringBytes += s.size();
+
+        // Lay the arrays out exactly as in the sidecar so both paths share the accessors
+        std::vector<char>& owned = *owned_;
+        owned.assign(numOff(), 0);
+        memcpy(owned.data(), &h, sizeof(h));
+        base_ = owned.data();
+        owned.resize(totalSize(), 0);
+        base_ = owned.data();
+        double* columns = reinterpret_cast<double*>(owned.data() + numOff());
+        for (size_t r = 0; r < h.rows; r++)
+            for (int f = 0; f < NUM_NUMERIC; f++) columns[f * h.rows + r] = num[r * NUM_NUMERIC + f];
+        for (int k = 0; k <= NUM_TEXT; k++)
+            memcpy(owned.data() + u32Off() + k * h.rows * sizeof(uint32_t), u32[k]->data(), h.rows * sizeof(uint32_t));
+        uint64_t* off = reinterpret_cast<uint64_t*>(owned.data() + strOff());
+        char* bytes = owned.data() + bytesOff();
+        off[0] = 0;
+        for (size_t i = 0; i < strings.size(); i++) {
+            memcpy(bytes + off[i], strings[i].data(), strings[i].size());
+            off[i + 1] = off[i] + strings[i].size();
+        }
+        return ok && file.readable();
+    }
+
+    void writeCache(const std::string& cachePath) const {
+        PROFILE_SCOPE("sidecar write");
+        std::string tmp = cachePath + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            if (!out) return;   // read-only folder: keep working from memory
+            out.write(owned_->data(), owned_->size());
+            if (!out) {
+                out.close();
+                std::remove(tmp.c_str());
+                return;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, cachePath, ec);
+        if (ec) std::remove(tmp.c_str());
+    }
+
+    uint64_t srcSize_ = 0;
+    int64_t srcMtime_ = 0;
+    char* map_ = nullptr;
+    size_t mapLen_ = 0;
+    Scratch<char> owned_;
+    const char* base_ = nullptr;
+    EventTimeline timeline_;
+};
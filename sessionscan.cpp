@@ -0,0 +1,58 @@
+// Single-pass driver over the shook and noshook folders.
+// Each session is read once (through the .cols sidecar) and handed to every requested
+// window analysis of windowengine.h, which produce the same outputs as the separate tools:
+//   pupil      -> leftpupil.txt / rightpupil.txt      (shookpupil.cpp, noshookpupil.cpp)
+//   luminance  -> luminance/<index>luminance.txt      (luminanceshook.cpp, luminancenoshook.cpp)
+//   pupilsize  -> pupil size/<index>pupil.txt         (pupilsizeshook.cpp, pupilsizenoshook.cpp)
+//   timing     -> "0.2 seconds" to "shook" report     (calculations.cpp, shook only)
+// Pass analyzer names on the command line to run a subset, default is all of them.
+// Sessions of both conditions share one thread pool.
+//g++ -std=c++17 -O2 sessionscan.cpp -o sessionscan -pthread
+//usage: ./sessionscan [pupil] [luminance] [pupilsize] [timing] [--condition shook|noshook|both] [-j threads] [--incremental] [--quiet] [--binary]
+#include <iostream>
+#include <string>
+#include <vector>
+#include "windowengine.h"
+using namespace std;
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+    
+    unsigned analyses = 0;
+    vector<const Condition*> conditions = {&kShook, &kNoshook};
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--condition" && i + 1 < argc) {
+            string c = argv[++i];
+            if (c == "shook") conditions = {&kShook};
+            else if (c == "noshook") conditions = {&kNoshook};
+            else if (c == "both") conditions = {&kShook, &kNoshook};
+            else {
+                cerr << "Error: unknown condition '" << c << "' (shook, noshook, both)" << endl;
+                return 1;
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            i++;
+        } else if (arg.rfind("-j", 0) == 0 || arg == "--incremental" || arg == "--quiet" ||
+                   arg == "-q" || arg == "--binary") {
+            continue;
+        } else if (arg == "pupil") {
+            analyses |= PUPIL_AVERAGES;
+        } else if (arg == "luminance") {
+            analyses |= LUMINANCE;
+        } else if (arg == "pupilsize") {
+            analyses |= PUPIL_SIZE;
+        } else if (arg == "timing") {
+            analyses |= EVENT_TIMING;
+        } else {
+            cerr << "Error: unknown analyzer '" << arg << "' (pupil, luminance, pupilsize, timing)" << endl;
+            return 1;
+        }
+    }
+    if (analyses == 0) analyses = PUPIL_AVERAGES | LUMINANCE | PUPIL_SIZE | EVENT_TIMING;
+
+    int status = runWindowAnalyses(conditions, analyses, parseWindowRunOptions(argc, argv));
+    if (status == 0) cout << "\nProcessing complete." << endl;
+    return status;
+}
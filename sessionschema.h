@@ -0,0 +1,172 @@
+// Column schema of the session CSV exports.
+// Every column a tool reads is one FieldSpec in kSessionSchema: the header text it is
+// found by, how that text is matched, which match wins when several header cells
+// match, and how its cells are parsed. resolveSchema applies all of them in one pass
+// over the header row and reports what it could not settle, so a change in the export
+// layout shows up as a missing or ambiguous field instead of a column read as another.
+//
+// The match rules are the ones the tools have always used (leftPupil, rightPupil and
+// robotEvent case-sensitive, positions and roomEvent case-insensitive; the gaze
+// columns and LookingAt by whole name, as the gaze scripts found them). Luminance has
+// its own header now; files without one keep the old rule, the column just before
+// leftPupil, and are reported as inferred.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "csvreader.h"
+
+enum SessionField {
+    COL_TIME, COL_LUMINANCE, COL_LEFT_PUPIL, COL_RIGHT_PUPIL,
+    COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ,
+    COL_GX, COL_GY, COL_GZ,
+    NUM_NUMERIC,
+    COL_ROBOT_EVENT = NUM_NUMERIC, COL_ROOM_EVENT, COL_LOOKING_AT,
+    NUM_FIELDS,
+    NUM_TEXT = NUM_FIELDS - NUM_NUMERIC
+};
+
+enum class HeaderMatch {
+    POSITION,           // fixed column index, the header text is not looked at
+    CONTAINS,           // trimmed cell contains the name
+    CONTAINS_ANY_CASE,  // lower-cased cell contains the (lower-case) name
+    EQUALS_ANY_CASE,    // trimmed, lower-cased cell is the name
+};
+enum class FieldPick { FIRST, LAST };
+enum class CellParse {
+    STOD,    // stod rules: leading spaces and trailing junk ignored (time, pupil, luminance)
+    STRICT,  // the whole cell must be a number (positions, as in speed.cpp)
+    TEXT,    // interned into the session's string table (event columns)
+};
+
+struct FieldSpec {
+    SessionField field;
+    const char* name;   // header text, or "" for POSITION
+    HeaderMatch match;
+    FieldPick pick;
+    CellParse parse;
+    int position;       // column index for POSITION, -1 otherwise
+};
+
+inline constexpr FieldSpec kSessionSchema[] = {
+    {COL_TIME, "", HeaderMatch::POSITION, FieldPick::FIRST, CellParse::STOD, 0},
+    {COL_LUMINANCE, "luminance", HeaderMatch::EQUALS_ANY_CASE, FieldPick::FIRST, CellParse::STOD, -1},
+    {COL_LEFT_PUPIL, "leftPupil", HeaderMatch::CONTAINS, FieldPick::LAST, CellParse::STOD, -1},
+    {COL_RIGHT_PUPIL, "rightPupil", HeaderMatch::CONTAINS, FieldPick::LAST, CellParse::STOD, -1},
+    {COL_PX, "playervr.x", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::STRICT, -1},
+    {COL_PY, "playervr.y", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::STRICT, -1},
+    {COL_PZ, "playervr.z", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::STRICT, -1},
+    {COL_RX, "robot.x", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::STRICT, -1},
+    {COL_RY, "robot.y", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::STRICT, -1},
+    {COL_RZ, "robot.z", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::STRICT, -1},
+    {COL_GX, "gaze visualizer.x", HeaderMatch::EQUALS_ANY_CASE, FieldPick::FIRST, CellParse::STRICT, -1},
+    {COL_GY, "gaze visualizer.y", HeaderMatch::EQUALS_ANY_CASE, FieldPick::FIRST, CellParse::STRICT, -1},
+    {COL_GZ, "gaze visualizer.z", HeaderMatch::EQUALS_ANY_CASE, FieldPick::FIRST, CellParse::STRICT, -1},
+    {COL_ROBOT_EVENT, "robotEvent", HeaderMatch::CONTAINS, FieldPick::FIRST, CellParse::TEXT, -1},
+    {COL_ROOM_EVENT, "roomevent", HeaderMatch::CONTAINS_ANY_CASE, FieldPick::LAST, CellParse::TEXT, -1},
+    {COL_LOOKING_AT, "lookingat", HeaderMatch::EQUALS_ANY_CASE, FieldPick::FIRST, CellParse::TEXT, -1},
+};
+inline constexpr size_t kSchemaSize = sizeof(kSessionSchema) / sizeof(kSessionSchema[0]);
+
+namespace schema_detail {
+constexpr bool isLower(const char* s) {
+    for (; *s; s++)
+        if (*s >= 'A' && *s <= 'Z') return false;
+    return true;
+}
+// Every field described once, in enum order, numbers parsed as numbers and event
+// columns interned, any-case names written in lower case
+constexpr bool valid() {
+    if (kSchemaSize != NUM_FIELDS) return false;
+    for (size_t i = 0; i < kSchemaSize; i++) {
+        const FieldSpec& f = kSessionSchema[i];
+        if (f.field != (SessionField)i) return false;
+        if ((f.parse == CellParse::TEXT) != (f.field >= NUM_NUMERIC)) return false;
+        if ((f.match == HeaderMatch::POSITION) != (f.position >= 0)) return false;
+        if ((f.match == HeaderMatch::CONTAINS_ANY_CASE || f.match == HeaderMatch::EQUALS_ANY_CASE) &&
+            !isLower(f.name))
+            return false;
+    }
+    return true;
+}
+}  // namespace schema_detail
+static_assert(schema_detail::valid(), "kSessionSchema must describe every SessionField once, in order");
+
+inline constexpr const FieldSpec& fieldSpec(SessionField f) { return kSessionSchema[f]; }
+
+// Outcome of matching the schema against one header row. Masks have bit f set for
+// SessionField f.
+struct SchemaResolution {
+    int32_t cols[NUM_FIELDS];   // column of each field, -1 when the header has none
+    uint32_t missing = 0;       // no header cell matched
+    uint32_t ambiguous = 0;     // more than one header cell matched; pick decided
+    bool luminanceInferred = false;   // no luminance header, taken from before leftPupil
+
+    bool has(SessionField f) const { return cols[f] >= 0; }
+};
+
+inline SchemaResolution resolveSchema(const CSVRow& headerRow) {
+    SchemaResolution res;
+    uint32_t seen = 0;
+    for (int f = 0; f < NUM_FIELDS; f++) res.cols[f] = -1;
+    std::string lc;   // lower-cased header cell, one buffer for the whole row
+    for (size_t i = 0; i < headerRow.size(); i++) {
+        std::string_view cell = trim(headerRow[i]);
+        lc.assign(headerRow[i]);
+        for (char& ch : lc) ch = tolower(static_cast<unsigned char>(ch));
+        std::string_view lcTrimmed = trim(lc);
+        for (const FieldSpec& spec : kSessionSchema) {
+            bool hit = false;
+            switch (spec.match) {
+                case HeaderMatch::POSITION: hit = (int)i == spec.position; break;
+                case HeaderMatch::CONTAINS: hit = cell.find(spec.name) != std::string_view::npos; break;
+                case HeaderMatch::CONTAINS_ANY_CASE: hit = lc.find(spec.name) != std::string::npos; break;
+                case HeaderMatch::EQUALS_ANY_CASE: hit = lcTrimmed == spec.name; break;
+            }
+            if (!hit) continue;
+            uint32_t bit = 1u << spec.field;
+            if (seen & bit) res.ambiguous |= bit;
+            if (!(seen & bit) || spec.pick == FieldPick::LAST) res.cols[spec.field] = i;
+            seen |= bit;
+        }
+    }
+    if (res.cols[COL_LUMINANCE] == -1 && res.cols[COL_LEFT_PUPIL] > 0) {
+        res.cols[COL_LUMINANCE] = res.cols[COL_LEFT_PUPIL] - 1;
+        res.luminanceInferred = true;
+        seen |= 1u << COL_LUMINANCE;
+    }
+    res.missing = ((1u << NUM_FIELDS) - 1) & ~seen;
+    return res;
+}
+
+// Per column of the file, the fields its cells feed (bit f for SessionField f; 0 for
+// a column no field reads), so a parser looks a cell up instead of the header
+class ColumnPlan {
+public:
+    ColumnPlan() = default;
+    explicit ColumnPlan(const int32_t* cols) {
+        for (int f = 0; f < NUM_FIELDS; f++)
+            if (cols[f] >= 0 && (size_t)cols[f] >= fields_.size()) fields_.resize(cols[f] + 1, 0);
+        for (int f = 0; f < NUM_FIELDS; f++)
+            if (cols[f] >= 0) fields_[cols[f]] |= 1u << f;
+    }
+    uint32_t fields(size_t c) const { return c < fields_.size() ? fields_[c] : 0; }
+    // One past the last column any field reads
+    size_t width() const { return fields_.size(); }
+
+private:
+    std::vector<uint32_t> fields_;
+};
+
+// "leftPupil, robotEvent" style list of the fields in mask
+inline std::string fieldNames(uint32_t mask) {
+    std::string out;
+    for (const FieldSpec& spec : kSessionSchema) {
+        if (!(mask >> spec.field & 1)) continue;
+        if (!out.empty()) out += ", ";
+        out += spec.match == HeaderMatch::POSITION ? "time" : spec.name;
+    }
+    return out;
+}
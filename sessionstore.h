@@ -0,0 +1,121 @@
+// Bounded in-memory caches for a resident process (analysisd.cpp).
+// LruCache keeps the most recently used values up to a fixed count. A value is looked
+// up by key together with the signature of the files it was built from
+// (Manifest::signature), so an entry whose inputs changed on disk is rebuilt on its
+// next use instead of being served stale. Values are handed out as shared_ptr: an
+// entry evicted while a request still holds it lives until that request is done.
+// A value is built outside the lock, so a slow load does not hold up requests for
+// other keys; two requests missing the same key at once both build it and the later
+// one is kept.
+//
+// FolderListing remembers indexedFiles() of a folder until the folder itself changes,
+// so a query does not re-read the directory.
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "parallel.h"
+
+template <class V>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    // Value of key, built by build() (returning std::shared_ptr<const V>) when it is
+    // not cached or was cached under another signature
+    template <class Build>
+    std::shared_ptr<const V> get(const std::string& key, const std::string& signature, Build build) {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            auto it = map_.find(key);
+            if (it != map_.end() && it->second->signature == signature) {
+                order_.splice(order_.begin(), order_, it->second);
+                hits_++;
+                return it->second->value;
+            }
+        }
+        std::shared_ptr<const V> value = build();
+        std::lock_guard<std::mutex> lock(m_);
+        misses_++;
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            order_.erase(it->second);
+            map_.erase(it);
+        }
+        order_.push_front({key, signature, value});
+        map_[key] = order_.begin();
+        while (order_.size() > capacity_) {
+            map_.erase(order_.back().key);
+            order_.pop_back();
+        }
+        return value;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_);
+        order_.clear();
+        map_.clear();
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_);
+        return order_.size();
+    }
+    uint64_t hits() const {
+        std::lock_guard<std::mutex> lock(m_);
+        return hits_;
+    }
+    uint64_t misses() const {
+        std::lock_guard<std::mutex> lock(m_);
+        return misses_;
+    }
+
+private:
+    struct Entry {
+        std::string key, signature;
+        std::shared_ptr<const V> value;
+    };
+
+    size_t capacity_;
+    mutable std::mutex m_;
+    std::list<Entry> order_;   // most recently used first
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> map_;
+    uint64_t hits_ = 0, misses_ = 0;
+};
+
+class FolderListing {
+public:
+    // indexedFiles(folder, ext), empty when the folder does not exist
+    std::vector<std::filesystem::path> files(const std::filesystem::path& folder, const std::string& ext) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        int64_t mtime = fs::last_write_time(folder, ec).time_since_epoch().count();
+        if (ec || !fs::is_directory(folder, ec)) return {};
+        std::string key = folder.string() + '\n' + ext;
+        std::lock_guard<std::mutex> lock(m_);
+        Listing& l = listings_[key];
+        if (!l.valid || l.mtime != mtime) {
+            l.files = indexedFiles(folder, ext);
+            l.mtime = mtime;
+            l.valid = true;
+        }
+        return l.files;
+    }
+
+private:
+    struct Listing {
+        bool valid = false;
+        int64_t mtime = 0;
+        std::vector<std::filesystem::path> files;
+    };
+    std::mutex m_;
+    std::map<std::string, Listing> listings_;
+};
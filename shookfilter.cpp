@@ -3,41 +3,25 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
+#include "csvreader.h"
+#include "eventlocator.h"
+#include "datasetindex.h"
 
 using namespace std;
 namespace fs = filesystem;
 
-// Function to check if a file has a .csv extension
-bool isCSVFile(const fs::path& filePath) {
-    return filePath.extension() == ".csv";
-}
-
-// Function to read a CSV file and check if it contains the target string
+// Function to read a CSV file and check if it contains the target string.
+// The mapped file is searched in place and the search stops at the first match.
 bool containsTargetString(const string& filePath, const string& target) {
-    ifstream file(filePath);
-    
-    if (!file.is_open()) {
-        cerr << "Error: Could not open " << filePath << endl;
-        return false; // File couldn't be opened
-    }
-
-    string line;
-    while (getline(file, line)) { // Read each line
-        stringstream ss(line);
-        string cell;
-
-        while (getline(ss, cell, ',')) { // Split by commas
-            if (cell.find(target) != string::npos) { // Check if "shook" exists
-                file.close(); return true;
-            }
-        }
-    }
-    file.close();
-    return false;
+    MappedFile file(filePath);
+    if (!file.isOpen()) return false; // File couldn't be opened
+    return EventPatterns({target}).scan(file.text())[0].found();
 }
 
-int main() {
+int main(int argc, char** argv) {
     string path = "."; // Default to current directory
+    Compression compress; // --compress gz|zst: store compressed copies in "shook"
+    if (!parseCompressOption(argc, argv, compress)) return 1;
     string targetString = "shook"; // String to search for
     fs::path shookFolder = fs::path(path) / "shook";
 
@@ -48,17 +32,19 @@ int main() {
 
     cout << "Scanning CSV files in: " << path << endl;
 
-    for (const auto& entry : fs::directory_iterator(path)) {
-        if (fs::is_regular_file(entry.path()) && isCSVFile(entry.path())) {
-            string fileName = entry.path().filename().string();
-            cout << "Checking file: " << fileName << endl;
-
-            if (containsTargetString(entry.path().string(), targetString)) {
-                // Move CSV file to the "shook" folder
-                fs::path newFilePath = shookFolder / fileName;
-                fs::rename(entry.path(), newFilePath);
-                cout << "Moved " << fileName << " to " << shookFolder << endl;
+    DatasetIndex dataset(path);
+    for (const DataFile* file : dataset.files(ROOT_DIR)) {
+        const string& fileName = file->name;
+        cout << "Checking file: " << fileName << '\n';
+
+        if (containsTargetString(file->path(path).string(), targetString)) {
+            // Move CSV file to the "shook" folder
+            fs::path newFilePath = moveFile(file->path(path), shookFolder / fileName, compress);
+            if (newFilePath.empty()) {
+                cerr << "❌ Could not move " << fileName << " to " << shookFolder << endl;
+                continue;
             }
+            cout << "Moved " << fileName << " to " << newFilePath.parent_path() << '\n';
         }
     }
 
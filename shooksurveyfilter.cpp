@@ -4,34 +4,23 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include "csvreader.h"
+#include "datasetindex.h"
+#include "eventlocator.h"
 
 namespace fs = std::filesystem;
 using namespace std;
 
-// Convert a string to lowercase
-string toLower(const string& str) {
-    string lowerStr = str;
-    transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(), ::tolower);
-    return lowerStr;
-}
-
-// Check if a file contains the target phrase
+// Check if a file contains the target phrase, case-insensitively. The mapped file is
+// searched in place, without a lowercased copy of every line.
 bool containsKeyword(const fs::path& filePath, const string& keyword) {
-    ifstream file(filePath);
-    if (!file.is_open()) return false;
-
-    string line;
-    while (getline(file, line)) {
-        if (toLower(line).find(keyword) != string::npos) {
-            return true;
-        }
-    }
-
-    return false;
+    MappedFile file(filePath.string());
+    if (!file.isOpen()) return false;
+    return EventPatterns({keyword}, true).scan(file.text())[0].found();
 }
 
 int main() {
-    vector<string> folders = {"shook", "noshook"};
+    vector<DataFolder> folders = {SHOOK_DIR, NOSHOOK_DIR};
     string keyword = "robot entered survey room";
     fs::path surveyFolder = fs::current_path() / "survey";
 
@@ -43,28 +32,26 @@ int main() {
     int totalCSV = 0, foundCount = 0;
     vector<string> missingIndices;
 
-    for (const auto& folder : folders) {
-        fs::path folderPath = fs::current_path() / folder;
-        if (!fs::exists(folderPath) || !fs::is_directory(folderPath)) {
-            cerr << "Warning: Folder '" << folder << "' does not exist or is not a directory.\n";
+    DatasetIndex dataset(fs::current_path());
+    for (DataFolder folder : folders) {
+        if (!dataset.folderExists(folder)) {
+            cerr << "Warning: Folder '" << kDataFolderNames[folder] << "' does not exist or is not a directory.\n";
             continue;
         }
 
-        for (const auto& entry : fs::directory_iterator(folderPath)) {
-            if (fs::is_regular_file(entry) && entry.path().extension() == ".csv") {
-                string fileName = entry.path().filename().string();
-                if (fileName.length() < 5) continue;
-                string index = fileName.substr(0, 5);
-                totalCSV++;
+        for (const DataFile* file : dataset.files(folder)) {
+            const string& fileName = file->name;
+            if (fileName.length() < 5) continue;
+            totalCSV++;
 
-                if (containsKeyword(entry.path(), keyword)) {
-                    foundCount++;
-                    // Move file to survey folder
-                    fs::path newLocation = surveyFolder / fileName;
-                    fs::rename(entry.path(), newLocation);
-                } else {
-                    missingIndices.push_back(index);
-                }
+            fs::path filePath = file->path(dataset.root());
+            if (containsKeyword(filePath, keyword)) {
+                foundCount++;
+                // Move file to survey folder
+                fs::path newLocation = surveyFolder / fileName;
+                fs::rename(filePath, newLocation);
+            } else {
+                missingIndices.push_back(file->index);
             }
         }
     }
@@ -4,168 +4,152 @@
 #include <sstream>
 #include <string>
 #include <vector>
-#include <map>
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include "sessioncache.h"
+#include "parallel.h"
+#include "speedkernel.h"
+#include "locationengine.h"
+#include "manifest.h"
+#include "resultsink.h"
 
 using namespace std;
 namespace fs = filesystem;
 
 // ---------- helpers ---------------------------------------------------------
 
-string toLower(string s) {
-    transform(s.begin(), s.end(), s.begin(),
-              [](unsigned char c) { return tolower(c); });
-    return s;
-}
-
 string extractIndex(const string& name) {
     return name.substr(0, 5);          // first 5 chars
 }
 
-bool parseDouble(const string& s, double& out) {
-    try {
-        size_t pos;
-        out = stod(s, &pos);
-        return pos == s.size();
-    } catch (...) {
-        return false;
+// Position columns read from a session, in the order playerVR.xyz, robot.xyz
+const SessionField kPositionFields[6] = {COL_PX, COL_PY, COL_PZ, COL_RX, COL_RY, COL_RZ};
+
+// Location timelines are written alongside the speeds when rooms is set
+struct LocationOutput {
+    const RoomMap* rooms = nullptr;
+    fs::path dir;
+};
+
+// Append the speed lines of one session to out, and its location runs to locations;
+// messages for skipped files go to err
+void appendSessionSpeeds(const fs::path& path, string& out, const LocationOutput& loc, string& locations, ostream& err) {
+    SessionColumns data(path.string());
+    if (data.empty()) {
+        err << "Empty file " << path << '\n';
+        return;
+    }
+
+    bool valid = true;
+    const double* pos[6];
+    for (int k = 0; k < 6; k++) {
+        valid = valid && data.column(kPositionFields[k]) >= 0;
+        pos[k] = data.values(kPositionFields[k]);
+    }
+    if (!valid) {
+        err << "Missing required columns in " << path << '\n';
+        return;
     }
+
+    Scratch<double> player, robot;
+    player->resize(data.rows());
+    robot->resize(data.rows());
+    frameSpeeds(pos, data.rows(), player->data(), robot->data());
+    appendSpeedLines(player->data(), robot->data(), data.rows(), out);
+
+    if (!loc.rooms) return;
+    LocationResult res = locateSession(data, extractIndex(path.filename().string()), *loc.rooms);
+    if (!res.problem.empty()) {
+        err << "No locations for " << path << ": " << res.problem << '\n';
+        return;
+    }
+    appendTimeline(locations, path.filename().string(), res);
 }
 
-struct ColSet {
-    int px{-1}, py{-1}, pz{-1};
-    int rx{-1}, ry{-1}, rz{-1};
-    bool valid() const {
-        return px >= 0 && py >= 0 && pz >= 0 &&
-               rx >= 0 && ry >= 0 && rz >= 0;
+// Write speed/<index>.txt (and speedlocation/<index>.txt) from all sessions of one index,
+// in file order
+IndexLog writeSpeedFile(const vector<fs::path>& sessions, const fs::path& speedDir, const LocationOutput& loc) {
+    IndexLog log;
+    string lines, locations;
+    for (const fs::path& path : sessions) appendSessionSpeeds(path, lines, loc, locations, log.err);
+    if (!locations.empty()) {
+        fs::path locPath = loc.dir / (extractIndex(sessions.front().filename().string()) + ".txt");
+        ofstream lout(locPath);
+        if (lout << kTimelineHeader << locations) log.out << "Wrote " << locPath << '\n';
+        else log.err << "Cannot write " << locPath << '\n';
     }
-};
+    if (lines.empty()) return log;
 
-ColSet locateColumns(const string& header) {
-    stringstream ss(header);
-    string cell;
-    int idx = 0;
-    ColSet cs;
-
-    while (getline(ss, cell, ',')) {
-        string lc = toLower(cell);
-        if (lc.find("playervr.x") != string::npos) cs.px = idx;
-        if (lc.find("playervr.y") != string::npos) cs.py = idx;
-        if (lc.find("playervr.z") != string::npos) cs.pz = idx;
-        if (lc.find("robot.x")    != string::npos) cs.rx = idx;
-        if (lc.find("robot.y")    != string::npos) cs.ry = idx;
-        if (lc.find("robot.z")    != string::npos) cs.rz = idx;
-        ++idx;
+    fs::path outPath = speedDir / (extractIndex(sessions.front().filename().string()) + ".txt");
+    ofstream fout(outPath);
+    if (!fout) {
+        log.err << "Cannot write " << outPath << '\n';
+        return log;
     }
-    return cs;
+    fout << "playerSpeed robotSpeed\n" << lines;
+    log.out << "Wrote " << outPath << '\n';
+    return log;
 }
 
 // ---------- main ------------------------------------------------------------
 
-int main() {
+int main(int argc, char** argv) {
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
+    bool incremental = parseIncremental(argc, argv);
     const fs::path intermediateDir = "intermediate";
     const fs::path speedDir        = "speed";
 
+    // --locations also writes each index's location timelines (locationengine.h) to
+    // speedlocation/<index>.txt from the same load: by roomEvent tag, or located in the
+    // region file given with --rooms
+    LocationOutput loc;
+    RoomMap rooms;
+    string roomsFile;
+    bool locations = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--locations") locations = true;
+        else if (arg == "--rooms" && i + 1 < argc) roomsFile = argv[++i], locations = true;
+    }
+    if (!roomsFile.empty()) {
+        string error;
+        rooms = RoomMap::load(roomsFile, error);
+        if (!error.empty()) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+    }
+    if (locations) {
+        loc.rooms = &rooms;
+        loc.dir = "speedlocation";
+    }
+
     if (!fs::exists(intermediateDir) || !fs::is_directory(intermediateDir)) {
         cerr << "Error: 'intermediate' folder not found.\n";
         return 1;
     }
     if (!fs::exists(speedDir)) fs::create_directory(speedDir);
-
-    map<string, vector<string>> speedLines;   // index -> lines
-
-    for (const auto& entry : fs::directory_iterator(intermediateDir)) {
-        if (!entry.is_regular_file() || entry.path().extension() != ".csv") continue;
-
-        string index = extractIndex(entry.path().filename().string());
-        ifstream fin(entry.path());
-        if (!fin) {
-            cerr << "Cannot open " << entry.path() << '\n';
-            continue;
-        }
-
-        string header;
-        if (!getline(fin, header)) {
-            cerr << "Empty file " << entry.path() << '\n';
-            continue;
-        }
-
-        ColSet cols = locateColumns(header);
-        if (!cols.valid()) {
-            cerr << "Missing required columns in " << entry.path() << '\n';
-            continue;
-        }
-
-        bool firstRow = true;
-        double pPrev[3]{}, rPrev[3]{};
-        string line;
-
-        while (getline(fin, line)) {
-            stringstream ss(line);
-            vector<string> cells;
-            string cell;
-            while (getline(ss, cell, ',')) cells.push_back(cell);
-
-            auto& buf = speedLines[index];
-
-            if (firstRow) {
-                buf.emplace_back("0 0");
-                parseDouble(cells[cols.px], pPrev[0]);
-                parseDouble(cells[cols.py], pPrev[1]);
-                parseDouble(cells[cols.pz], pPrev[2]);
-                parseDouble(cells[cols.rx], rPrev[0]);
-                parseDouble(cells[cols.ry], rPrev[1]);
-                parseDouble(cells[cols.rz], rPrev[2]);
-                firstRow = false;
-                continue;
-            }
-
-            double pCur[3], rCur[3];
-            bool ok =
-                parseDouble(cells[cols.px], pCur[0]) &&
-                parseDouble(cells[cols.py], pCur[1]) &&
-                parseDouble(cells[cols.pz], pCur[2]) &&
-                parseDouble(cells[cols.rx], rCur[0]) &&
-                parseDouble(cells[cols.ry], rCur[1]) &&
-                parseDouble(cells[cols.rz], rCur[2]);
-
-            if (!ok) {
-                buf.emplace_back("-1");
-                continue;
-            }
-
-            double pSpeed = sqrt(pow(pCur[0] - pPrev[0], 2) +
-                                 pow(pCur[1] - pPrev[1], 2) +
-                                 pow(pCur[2] - pPrev[2], 2));
-
-            double rSpeed = sqrt(pow(rCur[0] - rPrev[0], 2) +
-                                 pow(rCur[1] - rPrev[1], 2) +
-                                 pow(rCur[2] - rPrev[2], 2));
-
-            ostringstream oss;
-            oss << pSpeed << ' ' << rSpeed;
-            buf.emplace_back(oss.str());
-
-            copy(begin(pCur), end(pCur), begin(pPrev));
-            copy(begin(rCur), end(rCur), begin(rPrev));
-        }
-    }
-
-    // write out files
-    for (const auto& [idx, lines] : speedLines) {
-        fs::path outPath = speedDir / (idx + ".txt");
-        ofstream fout(outPath);
-        if (!fout) {
-            cerr << "Cannot write " << outPath << '\n';
-            continue;
-        }
-        fout << "playerSpeed robotSpeed\n";
-        for (const auto& ln : lines) fout << ln << '\n';
-        cout << "Wrote " << outPath << '\n';
+    if (locations && !fs::exists(loc.dir)) fs::create_directory(loc.dir);
+
+    // With --incremental, indices whose sessions are unchanged since the last run are skipped
+    Manifest manifest(locations ? "speed-location" : "speed");
+    vector<fs::path> extraInputs;
+    if (!roomsFile.empty()) extraInputs.push_back(roomsFile);
+    vector<IndexLog> logs = runIndexGroups(
+        manifest, groupByIndex(indexedFiles(intermediateDir, ".csv")), extraInputs, incremental, threads,
+        [&](const string& index) {
+            vector<fs::path> outputs = {speedDir / (index + ".txt")};
+            if (locations) outputs.push_back(loc.dir / (index + ".txt"));
+            return outputs;
+        },
+        [&](const vector<fs::path>& sessions) { return writeSpeedFile(sessions, speedDir, loc); });
+    for (const IndexLog& log : logs) {
+        cerr << log.err.str();
+        printProgress(cout, log.out.str(), quiet);
     }
 
     cout << "Done.\n";
     return 0;
-}
\ No newline at end of file
+}
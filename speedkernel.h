@@ -0,0 +1,65 @@
+// Per-frame player/robot speed over a session's position columns.
+// The speed of a frame is its distance from the last frame with a fully parsed
+// position. Rather than tracking that row by row, the positions are first
+// forward-filled (an unparsable row repeats the previous position, unparsable cells of
+// the first row count as 0), after which every speed is a plain distance between
+// neighbouring rows: one branch-free loop over contiguous x/y/z arrays that the
+// compiler vectorizes (-O3; add -fno-math-errno to vectorize the sqrt too).
+//
+// The first frame is 0 and a frame with an unparsable position is -1, as in the
+// speed files the tools have always written. The forward-filled copy lives in the
+// thread's scratch buffers (scratch.h).
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "scratch.h"
+
+// pos holds playerVR x/y/z then robot x/y/z, each n rows with NaN where a cell did not
+// parse. player and robot receive n speeds.
+inline void frameSpeeds(const double* const pos[6], size_t n, double* player, double* robot) {
+    if (n == 0) return;
+    Scratch<double> filledBuf, invalidBuf;
+    std::vector<double>& filled = *filledBuf;
+    std::vector<double>& invalid = *invalidBuf;
+    filled.resize(6 * n);
+    invalid.assign(n, 0.0);
+    for (int k = 0; k < 6; k++) filled[k * n] = std::isnan(pos[k][0]) ? 0.0 : pos[k][0];
+    for (size_t i = 1; i < n; i++) {
+        bool ok = true;
+        for (int k = 0; k < 6; k++) ok = ok && !std::isnan(pos[k][i]);
+        invalid[i] = !ok;
+        for (int k = 0; k < 6; k++) filled[k * n + i] = ok ? pos[k][i] : filled[k * n + i - 1];
+    }
+
+    const double *px = &filled[0], *py = &filled[n], *pz = &filled[2 * n];
+    const double *rx = &filled[3 * n], *ry = &filled[4 * n], *rz = &filled[5 * n];
+    const double* bad = invalid.data();
+    player[0] = robot[0] = 0.0;
+    for (size_t i = 1; i < n; i++) {
+        double dx = px[i] - px[i - 1], dy = py[i] - py[i - 1], dz = pz[i] - pz[i - 1];
+        double ex = rx[i] - rx[i - 1], ey = ry[i] - ry[i - 1], ez = rz[i] - rz[i - 1];
+        double p = std::sqrt(dx * dx + dy * dy + dz * dz);
+        double r = std::sqrt(ex * ex + ey * ey + ez * ez);
+        player[i] = bad[i] != 0.0 ? -1.0 : p;
+        robot[i] = bad[i] != 0.0 ? -1.0 : r;
+    }
+}
+
+// One speed-file line per frame: "0 0" first, "-1" for an unparsable frame, otherwise
+// "playerSpeed robotSpeed" in the default stream format (%g)
+inline void appendSpeedLines(const double* player, const double* robot, size_t n, std::string& out) {
+    char buf[64];
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0) {
+            out += "0 0\n";
+        } else if (player[i] < 0) {
+            out += "-1\n";
+        } else {
+            int len = snprintf(buf, sizeof(buf), "%g %g\n", player[i], robot[i]);
+            out.append(buf, len);
+        }
+    }
+}
@@ -0,0 +1,211 @@
+// One-pass summary statistics.
+// RunningStats keeps count, mean, the sum of squared deviations (Welford's update),
+// min and max of a stream of values, so no tool has to store every sample just to
+// report its spread, and the variance does not suffer from the cancellation of the
+// sumSq - sum^2/n form. Accumulators of separate files or threads are combined with
+// merge() (Chan et al.); merging in index order gives the same result for any thread
+// count.
+//
+// QuantileDigest adds medians and quartiles to those reports. The approximate mode is
+// a merging t-digest: values are buffered and folded into at most a few hundred
+// weighted centroids, small ones near the tails, so memory stays bounded however many
+// files are read, and digests of separate files merge like RunningStats. The exact mode
+// keeps every value (memory grows with the input) and interpolates like numpy's default.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class RunningStats {
+public:
+    void add(double x) {
+        n_++;
+        double d = x - mean_;
+        mean_ += d / n_;
+        m2_ += d * (x - mean_);
+        if (x < min_) min_ = x;
+        if (x > max_) max_ = x;
+    }
+
+    void merge(const RunningStats& o) {
+        if (o.n_ == 0) return;
+        if (n_ == 0) {
+            *this = o;
+            return;
+        }
+        double n = double(n_) + double(o.n_);
+        double d = o.mean_ - mean_;
+        mean_ += d * double(o.n_) / n;
+        m2_ += o.m2_ + d * d * double(n_) * double(o.n_) / n;
+        n_ += o.n_;
+        if (o.min_ < min_) min_ = o.min_;
+        if (o.max_ > max_) max_ = o.max_;
+    }
+
+    int64_t count() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    double mean() const { return n_ ? mean_ : 0.0; }
+    // Sample variance (Bessel's correction), 0 for fewer than two values
+    double variance() const { return n_ > 1 ? m2_ / double(n_ - 1) : 0.0; }
+    double populationVariance() const { return n_ ? m2_ / double(n_) : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+    // Sum of (x - about)^2 over the values, from the moments alone
+    double squaredDeviations(double about) const {
+        double d = mean_ - about;
+        return n_ ? m2_ + double(n_) * d * d : 0.0;
+    }
+    // numeric_limits max/lowest while empty, as the stats structs this replaces printed
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+private:
+    int64_t n_ = 0;
+    double mean_ = 0.0, m2_ = 0.0;
+    double min_ = std::numeric_limits<double>::max();
+    double max_ = std::numeric_limits<double>::lowest();
+};
+
+enum QuantileMode { NO_QUANTILES, APPROX_QUANTILES, EXACT_QUANTILES };
+
+// --quantiles (t-digest) or --exact-quantiles from argv
+inline QuantileMode parseQuantileMode(int argc, char** argv) {
+    QuantileMode mode = NO_QUANTILES;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quantiles") mode = APPROX_QUANTILES;
+        if (arg == "--exact-quantiles") mode = EXACT_QUANTILES;
+    }
+    return mode;
+}
+
+class QuantileDigest {
+public:
+    explicit QuantileDigest(QuantileMode mode = NO_QUANTILES, double compression = 200)
+        : mode_(mode), compression_(compression) {}
+
+    QuantileMode mode() const { return mode_; }
+
+    void add(double x) {
+        if (mode_ == NO_QUANTILES) return;
+        buffer_.push_back({x, 1});
+        if (mode_ == APPROX_QUANTILES && buffer_.size() >= kBufferFactor * compression_) compress();
+    }
+
+    void merge(const QuantileDigest& o) {
+        if (mode_ == NO_QUANTILES) return;
+        buffer_.insert(buffer_.end(), o.centroids_.begin(), o.centroids_.end());
+        buffer_.insert(buffer_.end(), o.buffer_.begin(), o.buffer_.end());
+        // o's centroids hold means, not its extremes, so those come over as they are
+        min_ = std::min(min_, o.min_);
+        max_ = std::max(max_, o.max_);
+        if (mode_ == APPROX_QUANTILES) compress();
+    }
+
+    // Value at quantile q in [0, 1]; NaN when empty
+    double quantile(double q) const {
+        compress();
+        if (centroids_.empty()) return NAN;
+        if (mode_ == EXACT_QUANTILES) {
+            double pos = q * double(centroids_.size() - 1);
+            size_t i = size_t(pos);
+            if (i + 1 >= centroids_.size()) return centroids_.back().mean;
+            return centroids_[i].mean + (pos - double(i)) * (centroids_[i + 1].mean - centroids_[i].mean);
+        }
+        // Each centroid sits at the middle of its weight; interpolate between neighbours,
+        // and towards the exact min/max beyond the outer ones
+        double total = 0;
+        for (const Centroid& c : centroids_) total += c.weight;
+        double target = q * total, cum = 0;
+        double prevMean = min_, prevCenter = 0;
+        for (const Centroid& c : centroids_) {
+            double center = cum + c.weight / 2;
+            if (target <= center) {
+                double t = center > prevCenter ? (target - prevCenter) / (center - prevCenter) : 1;
+                return prevMean + t * (c.mean - prevMean);
+            }
+            prevMean = c.mean;
+            prevCenter = center;
+            cum += c.weight;
+        }
+        double t = total > prevCenter ? (target - prevCenter) / (total - prevCenter) : 1;
+        return prevMean + t * (max_ - prevMean);
+    }
+
+private:
+    struct Centroid {
+        double mean, weight;
+    };
+    static constexpr double kBufferFactor = 5;
+
+    // k1 scale function of the t-digest paper: centroids may span one unit of k
+    double scale(double q) const { return compression_ / (2 * M_PI) * std::asin(2 * q - 1); }
+
+    void compress() const {
+        if (buffer_.empty()) return;
+        buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+        std::sort(buffer_.begin(), buffer_.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+        centroids_.clear();
+        if (mode_ == EXACT_QUANTILES) {
+            centroids_.swap(buffer_);
+            return;
+        }
+        min_ = std::min(min_, buffer_.front().mean);
+        max_ = std::max(max_, buffer_.back().mean);
+        double total = 0;
+        for (const Centroid& c : buffer_) total += c.weight;
+        Centroid cur = buffer_[0];
+        double before = 0, kLow = scale(0);
+        for (size_t i = 1; i < buffer_.size(); i++) {
+            const Centroid& c = buffer_[i];
+            if (scale((before + cur.weight + c.weight) / total) - kLow <= 1) {
+                cur.weight += c.weight;
+                cur.mean += (c.mean - cur.mean) * c.weight / cur.weight;
+            } else {
+                centroids_.push_back(cur);
+                before += cur.weight;
+                kLow = scale(before / total);
+                cur = c;
+            }
+        }
+        centroids_.push_back(cur);
+        buffer_.clear();
+    }
+
+    QuantileMode mode_;
+    double compression_;
+    // Sorted centroids (every value in exact mode) and values not folded in yet;
+    // quantile() folds the buffer in first, hence mutable
+    mutable std::vector<Centroid> centroids_, buffer_;
+    mutable double min_ = std::numeric_limits<double>::max();
+    mutable double max_ = std::numeric_limits<double>::lowest();
+};
+
+// RunningStats plus, when quantiles were asked for, a digest of the same values
+struct SummaryStats {
+    RunningStats stats;
+    QuantileDigest quantiles;
+
+    explicit SummaryStats(QuantileMode mode = NO_QUANTILES) : quantiles(mode) {}
+    void add(double x) {
+        stats.add(x);
+        quantiles.add(x);
+    }
+    void merge(const SummaryStats& o) {
+        stats.merge(o.stats);
+        quantiles.merge(o.quantiles);
+    }
+};
+
+// "Median: m, Q1: a, Q3: b, IQR: c", empty when no quantiles were asked for
+inline std::string quantileSummary(const SummaryStats& s) {
+    if (s.quantiles.mode() == NO_QUANTILES) return "";
+    double q1 = s.quantiles.quantile(0.25), q3 = s.quantiles.quantile(0.75);
+    std::ostringstream out;
+    out << "Median: " << s.quantiles.quantile(0.5) << ", Q1: " << q1 << ", Q3: " << q3 << ", IQR: " << q3 - q1;
+    return out.str();
+}
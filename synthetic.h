@@ -0,0 +1,117 @@
+// Synthetic Fire2 sessions for benchmarks and trying the tools without participant data.
+// writeSyntheticDataset() lays out a dataset as the tools expect it:
+//   shook/<index>_Standard_Office.csv     odd indices, "robot shook" after the 0.2 s tag
+//   noshook/<index>_Standard_Office.csv   even indices, no shook event
+//   survey/<index>_Survey.csv, intermediate/<index>_Intermediate.csv, evolab/<index>_evolab.csv
+//   output_mappings/<index>_luminance_mapping.txt
+// Sessions have the recorded column layout (Time, Event, robotEvent, roomEvent,
+// PlayerVR.xyz, Robot.xyz, Gaze Visualizer.xyz, luminance, leftPupil, rightPupil,
+// LookingAt) at about 100 rows per second, with calibration markers, the "robot says
+// 0.2 seconds" tag halfway through, "Robot Entered Survey Room" near the end, about one
+// pupil sample in ten dropped to -1 and LookingAt in runs of "Robot", "smoothfaced",
+// "Wall" or nothing. Each file draws from its own (seed, participant, file) stream of
+// CounterRng, so the same arguments always write the same bytes.
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "resample.h"
+
+struct SyntheticOptions {
+    size_t participants = 6;
+    size_t rows = 3000;          // rows per session CSV
+    uint64_t seed = 1;
+    int firstIndex = 10001;
+};
+
+// Random stream of each file of a participant
+enum SyntheticKind { SYN_SESSION, SYN_SURVEY, SYN_INTERMEDIATE, SYN_EVOLAB, SYN_MAPPING };
+
+// CSV text of one session. shook adds the "robot shook" event 12 rows after the tag.
+inline std::string syntheticSessionCSV(size_t rows, uint64_t seed, uint64_t stream, bool shook) {
+    CounterRng rng(seed, stream);
+    // LookingAt draws from a stream of its own, so the other columns do not depend on it
+    CounterRng lookRng(seed, stream | (uint64_t(1) << 63));
+    static const char* const kLookTargets[] = {"", "Robot", "smoothfaced", "Wall"};
+    std::string out = "Time,Event,robotEvent,roomEvent,PlayerVR.x,PlayerVR.y,PlayerVR.z,Robot.x,Robot.y,Robot.z,"
+                      "Gaze Visualizer.x,Gaze Visualizer.y,Gaze Visualizer.z,luminance,leftPupil,rightPupil,"
+                      "LookingAt\n";
+    out.reserve(rows * 110);
+    size_t tagRow = rows / 2, shookRow = tagRow + 12, surveyRow = rows * 9 / 10;
+    double t = 0, px = 0, pz = 0, rx = 0, rz = 0, heading = rng.uniform(0, 2 * M_PI);
+    char line[320];
+    const char* look = "";
+    for (size_t r = 0; r < rows; r++) {
+        t += rng.uniform(0.008, 0.012);
+        heading += rng.uniform(-0.05, 0.05);
+        double step = rng.uniform(0.0, 0.02);
+        px += step * cos(heading);
+        pz += step * sin(heading);
+        rx += (px - 0.5 - rx) * 0.02 + rng.uniform(-0.01, 0.01);
+        rz += (pz - 0.5 - rz) * 0.02 + rng.uniform(-0.01, 0.01);
+        const char* event = r == 5 ? "Start Calibration" : r == 50 ? "finished calibration" : "";
+        const char* robotEvent = r == tagRow ? "robot says 0.2 seconds" : (shook && r == shookRow) ? "robot shook" : "";
+        const char* roomEvent = r == surveyRow ? "Robot Entered Survey Room" : "";
+        double lum = rng.uniform(0.0, 1.0);
+        // About one pupil sample in ten is lost (-1), as with blinks
+        double left = rng.uniform(0, 1) < 0.1 ? -1 : rng.uniform(2.5, 5.0);
+        double right = rng.uniform(0, 1) < 0.1 ? -1 : rng.uniform(2.5, 5.0);
+        if (lookRng.uniform() < 0.05) look = kLookTargets[lookRng.below(4)];
+        snprintf(line, sizeof line, "%.4f,%s,%s,%s,%.4f,0.0000,%.4f,%.4f,0.0000,%.4f,%.4f,%.4f,%.4f,%.4g,%.5g,%.5g,%s\n",
+                 t, event, robotEvent, roomEvent, px, pz, rx, rz, rng.uniform(-1, 1), rng.uniform(-1, 1), rng.uniform(-1, 1),
+                 lum, left, right, look);
+        out += line;
+    }
+    return out;
+}
+
+// Luminance mapping in 0.025 steps, pupil size falling with luminance
+inline std::string syntheticMapping(uint64_t seed, uint64_t stream) {
+    CounterRng rng(seed, stream);
+    std::string out = "luminance avgLeft countLeft sdLeft avgRight countRight sdRight\n";
+    char line[160];
+    for (int k = 0; k <= 40; k++) {
+        double lum = k * 0.025;
+        snprintf(line, sizeof line, "%.3f %.4f %d %.4f %.4f %d %.4f\n", lum, 4.0 - lum + rng.uniform(-0.05, 0.05),
+                 int(rng.uniform(5, 40)), rng.uniform(0.1, 0.3), 4.0 - lum + rng.uniform(-0.05, 0.05), int(rng.uniform(5, 40)),
+                 rng.uniform(0.1, 0.3));
+        out += line;
+    }
+    return out;
+}
+
+inline bool writeTextFile(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(text.data(), text.size());
+    return bool(out);
+}
+
+// Write a whole synthetic dataset under root; false when a file could not be written
+inline bool writeSyntheticDataset(const std::filesystem::path& root, const SyntheticOptions& opt, int threads = 1) {
+    namespace fs = std::filesystem;
+    for (const char* dir : {"shook", "noshook", "survey", "intermediate", "evolab", "output_mappings"})
+        fs::create_directories(root / dir);
+    std::vector<char> ok(opt.participants, 1);
+    parallelFor(opt.participants, threads, [&](size_t p) {
+        std::string index = std::to_string(opt.firstIndex + p);
+        bool shook = p % 2 == 0;
+        uint64_t stream = p * 8;
+        auto write = [&](const fs::path& path, const std::string& text) {
+            if (!writeTextFile(path, text)) ok[p] = 0;
+        };
+        write(root / (shook ? "shook" : "noshook") / (index + "_Standard_Office.csv"),
+              syntheticSessionCSV(opt.rows, opt.seed, stream + SYN_SESSION, shook));
+        write(root / "survey" / (index + "_Survey.csv"), syntheticSessionCSV(opt.rows / 2, opt.seed, stream + SYN_SURVEY, true));
+        write(root / "intermediate" / (index + "_Intermediate.csv"),
+              syntheticSessionCSV(opt.rows / 2, opt.seed, stream + SYN_INTERMEDIATE, true));
+        write(root / "evolab" / (index + "_evolab.csv"), syntheticSessionCSV(opt.rows / 4, opt.seed, stream + SYN_EVOLAB, true));
+        write(root / "output_mappings" / (index + "_luminance_mapping.txt"), syntheticMapping(opt.seed, stream + SYN_MAPPING));
+    });
+    for (char c : ok)
+        if (!c) return false;
+    return true;
+}
@@ -7,6 +7,7 @@
 #include <filesystem>
 #include <boost/math/distributions/students_t.hpp>
 #include <limits>
+#include "calibrationtable.h"
 using namespace std;
 using namespace boost::math;
 namespace fs = filesystem;
@@ -30,29 +31,6 @@ struct PupilData {
     double stdDev;
 };
 
-// Function to read luminance-pupil mapping for a given index (separately for left & right)
-pair<map<double, PupilData>, map<double, PupilData>> readLuminanceMapping(const string &index, const string &folderPath) {
-    map<double, PupilData> leftMapping, rightMapping;
-    fs::path filePath = fs::path(folderPath) / (index + "_luminance_mapping.txt");
-
-    ifstream inFile(filePath);
-    if (!inFile) {
-        return {leftMapping, rightMapping}; // Return empty maps (indicates missing data)
-    }
-
-    string header;
-    getline(inFile, header); // Skip header
-
-    double luminance, avgLeft, leftCount, leftStd, avgRight, rightCount, rightStd;
-    while (inFile >> luminance >> avgLeft >> leftCount >> leftStd >> avgRight >> rightCount >> rightStd) {
-        leftMapping[luminance] = {luminance, avgLeft, (int)leftCount, leftStd};
-        rightMapping[luminance] = {luminance, avgRight, (int)rightCount, rightStd};
-    }
-
-    inFile.close();
-    return {leftMapping, rightMapping};
-}
-
 // Function to read pupil data from file (left or right) - Now only extracting before data
 map<string, PupilData> readPupilData(const string &filename) {
     map<string, PupilData> data;
@@ -73,18 +51,6 @@ map<string, PupilData> readPupilData(const string &filename) {
     return data;
 }
 
-// Function to find the closest luminance match in mapping
-PupilData getClosestLuminanceMatch(const map<double, PupilData> &mapping, double targetLum) {
-    if (mapping.empty()) return {-1, -1, -1, -1}; // Return invalid data
-
-    auto it = mapping.lower_bound(targetLum);
-    if (it == mapping.end()) return prev(it)->second;
-    if (it == mapping.begin()) return it->second;
-
-    auto lower = prev(it);
-    return (abs(lower->first - targetLum) < abs(it->first - targetLum)) ? lower->second : it->second;
-}
-
 // Function to perform two-sample t-test
 double computeTTest(double mean1, double std1, int n1, double mean2, double std2, int n2) {
     if (n1 < 2 || n2 < 2) return -1.0; // Not enough data for t-test
@@ -126,9 +92,9 @@ int main() {
 
     for (const string &index : indices) {
         // Read luminance mapping for the current index
-        auto [leftLuminanceMapping, rightLuminanceMapping] = readLuminanceMapping(index, calibrationFolder);
+        CalibrationTable luminanceMapping((fs::path(calibrationFolder) / (index + "_luminance_mapping.txt")).string());
 
-        if (leftLuminanceMapping.empty() || rightLuminanceMapping.empty()) {
+        if (luminanceMapping.empty()) {
             missingLuminanceMappingCount++;
             cout << index << "\tMISSING\tMISSING\tMISSING\tMISSING\n";
             continue;
@@ -145,8 +111,8 @@ int main() {
         PupilData rightActual = rightPupilData[index];
 
         // Get expected values from closest luminance in mapping (using luminance BEFORE)
-        PupilData leftExpected = getClosestLuminanceMatch(leftLuminanceMapping, leftActual.luminance);
-        PupilData rightExpected = getClosestLuminanceMatch(rightLuminanceMapping, rightActual.luminance);
+        CalibrationTable::Entry leftExpected = luminanceMapping.nearest(CalibrationTable::LEFT, leftActual.luminance);
+        CalibrationTable::Entry rightExpected = luminanceMapping.nearest(CalibrationTable::RIGHT, rightActual.luminance);
 
         // Compute t-test for left and right pupil sizes
         double leftPValue = computeTTest(leftActual.avgSize, leftActual.stdDev, leftActual.count,
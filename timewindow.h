@@ -0,0 +1,98 @@
+// Time windows over a session's time column.
+// The tools all look at rows whose time falls inside a window around an event, e.g.
+// [t - 5 s, t] before the "0.2 seconds" tag and [t', t' + 5 s] after it. Session time
+// only ever increases, so the window bounds are found by binary search over the parsed
+// time column and only the rows inside a window are visited; the rest of the file is
+// never touched, however many windows are asked for.
+//
+// Unparsable time cells are NaN and are never reported. If a file's times are not in
+// order after all, TimeIndex falls back to checking every row, so results are the same
+// either way.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "csvreader.h"
+#include "scratch.h"
+
+// A window relative to an event time t: [t + offset + from, t + offset + to], both
+// ends inclusive. offset moves the anchor first (the estimated onset 0.229 s after the
+// "0.2 seconds" tag), from/to then give the window around the moved anchor.
+struct TimeWindow {
+    double offset = 0.0;
+    double from = 0.0, to = 0.0;
+
+    // The length seconds leading up to anchor t + offset
+    static TimeWindow before(double length, double offset = 0.0) { return {offset, -length, 0.0}; }
+    // The length seconds starting at anchor t + offset
+    static TimeWindow after(double length, double offset = 0.0) { return {offset, 0.0, length}; }
+
+    double lo(double t) const { return (t + offset) + from; }
+    double hi(double t) const { return (t + offset) + to; }
+};
+
+class TimeIndex {
+public:
+    // time[0..rows) is the parsed time column; it must outlive the index
+    TimeIndex(const double* time, size_t rows) : time_(time), rows_(rows) {
+        // Binary search runs over a copy where each NaN takes the previous time, so the
+        // gaps do not break the ordering. Files without gaps are searched in place.
+        bool gaps = std::any_of(time, time + rows, [](double t) { return std::isnan(t); });
+        if (gaps) {
+            filled_->resize(rows);
+            double last = -std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < rows; i++) (*filled_)[i] = last = std::isnan(time[i]) ? last : time[i];
+        }
+        const double* key = search();
+        monotonic_ = std::is_sorted(key, key + rows);
+    }
+
+    size_t rows() const { return rows_; }
+    bool monotonic() const { return monotonic_; }
+
+    // Row range [first, last) whose times lie in [lo, hi]. Rows in the range with a
+    // NaN time are not in the window; forEach skips them.
+    std::pair<size_t, size_t> range(double lo, double hi) const {
+        if (!monotonic_) return {0, rows_};
+        const double* key = search();
+        size_t first = std::lower_bound(key, key + rows_, lo) - key;
+        size_t last = std::upper_bound(key + first, key + rows_, hi) - key;
+        return {first, std::max(first, last)};
+    }
+
+    // Call fn(row) for every row with lo <= time <= hi, in row order
+    template <class Fn>
+    void forEach(double lo, double hi, Fn fn) const {
+        auto [first, last] = range(lo, hi);
+        for (size_t i = first; i < last; i++)
+            if (time_[i] >= lo && time_[i] <= hi) fn(i);
+    }
+    template <class Fn>
+    void forEach(const TimeWindow& w, double t, Fn fn) const {
+        forEach(w.lo(t), w.hi(t), fn);
+    }
+
+private:
+    const double* search() const { return filled_->empty() ? time_ : filled_->data(); }
+
+    const double* time_;
+    size_t rows_;
+    Scratch<double> filled_;   // gap-filled times, empty when there are no gaps
+    bool monotonic_ = true;
+};
+
+// Time column of a CSV with a header row, parsed with the stod rules: entry r is data
+// row r + 1, NaN where the cell is missing or does not parse.
+inline std::vector<double> parseTimeColumn(const CSVFile& data, int timeCol = 0) {
+    std::vector<double> time(data.empty() ? 0 : data.size() - 1, NAN);
+    size_t failures = 0;
+    for (size_t r = 1; r < data.size(); r++) {
+        if (data[r].size() <= (size_t)timeCol) continue;
+        try { time[r - 1] = toDouble(data[r][timeCol]); } catch (...) { failures++; }
+    }
+    PROFILE_COUNT(PROF_PARSE_FAILURES, failures);
+    return time;
+}
@@ -0,0 +1,94 @@
+// Batch version of t_test_before.cpp / t_test_after.cpp.
+// Reads leftpupil.txt and rightpupil.txt once, loads every participant's
+// output_mappings/<index>_luminance_mapping.txt once, and runs the before and after
+// tests of both eyes against the nearest calibration row for any number of
+// significance levels in one go (see ttestengine.h). Nothing is asked on stdin.
+// Degrees of freedom are min(n1, n2) - 1 as in the interactive tools, or
+// Welch-Satterthwaite with --welch.
+// One tab-separated row per index, window and eye goes to stdout (or -o file); the pass
+// counts of every level go to stderr.
+//g++ -std=c++17 -O2 ttestbatch.cpp -o ttestbatch -pthread
+//usage: ./ttestbatch [--alpha 0.05,0.01,0.001] [--window before|after|both] [--welch] [-o table.tsv] [-j threads] [--quiet]
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include "ttestengine.h"
+#include "parallel.h"
+#include "resultsink.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    vector<double> alphas = {0.05};
+    vector<PupilHalf> halves = {BEFORE_EVENT, AFTER_EVENT};
+    bool welch = false;
+    string outName;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--alpha" && i + 1 < argc) {
+            try {
+                alphas = parseAlphas(argv[++i]);
+            } catch (...) {
+                cerr << "Error: --alpha takes a comma-separated list of numbers" << endl;
+                return 1;
+            }
+        } else if (arg == "--window" && i + 1 < argc) {
+            string w = argv[++i];
+            if (w == "before") halves = {BEFORE_EVENT};
+            else if (w == "after") halves = {AFTER_EVENT};
+            else if (w == "both") halves = {BEFORE_EVENT, AFTER_EVENT};
+            else {
+                cerr << "Error: unknown window '" << w << "' (before, after, both)" << endl;
+                return 1;
+            }
+        } else if (arg == "--welch") {
+            welch = true;
+        } else if (arg == "-o" && i + 1 < argc) {
+            outName = argv[++i];
+        }
+    }
+    int threads = parseThreads(argc, argv);
+    bool quiet = parseSinkOptions(argc, argv).quiet;
+    string calibrationFolder = "output_mappings";
+
+    vector<PupilRow> leftRows = readPupilTable("leftpupil.txt");
+    vector<PupilRow> rightRows = readPupilTable("rightpupil.txt");
+    if (leftRows.empty() || rightRows.empty()) {
+        cerr << "Error: One or both pupil data files are empty or could not be read.\n";
+        return 1;
+    }
+
+    vector<string> indices = pupilIndices(leftRows, rightRows);
+
+    // Every mapping is read once, whatever the number of windows and levels
+    vector<CalibrationTable> mappings = parallelMap<CalibrationTable>(indices.size(), threads, [&](size_t k) {
+        return CalibrationTable((fs::path(calibrationFolder) / (indices[k] + "_luminance_mapping.txt")).string());
+    });
+
+    vector<const CalibrationTable*> tables;
+    for (const CalibrationTable& mapping : mappings) tables.push_back(&mapping);
+    TestBatch batch = runTTests(indices, leftRows, rightRows, tables, halves, welch);
+
+    ofstream outFile;
+    if (!outName.empty()) {
+        outFile.open(outName);
+        if (!outFile) {
+            cerr << "Error: Could not open file " << outName << endl;
+            return 1;
+        }
+    }
+    ostream& out = outName.empty() ? cout : outFile;
+    writeTestTable(out, batch, alphas);
+
+    // Summary of every window and level, in the layout of the interactive tools
+    if (quiet) return 0;
+    printTestSummary(cerr, batch, halves, alphas, welch);
+    cerr << "Processing complete.\n";
+    return 0;
+}
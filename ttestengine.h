@@ -0,0 +1,169 @@
+// Pupil t-tests against the calibration.
+// For every index, window and eye, the measured window (a leftpupil.txt/rightpupil.txt
+// row, see pupiltable.h) is tested against the calibration row nearest to its average
+// luminance. The p-values of all tests are computed together from the regularized
+// incomplete beta function, p = I(df / (df + t^2); df/2, 1/2), which also stays
+// accurate for the tiny p-values that 2 * (1 - cdf) rounds off. Degrees of freedom are
+// min(n1, n2) - 1 as in the interactive tools, or Welch-Satterthwaite when asked.
+// ttestbatch.cpp runs it on the pupil tables, pipeline.cpp on the rows in memory.
+// Needs boost (header only).
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/math/special_functions/beta.hpp>
+#include "calibrationtable.h"
+#include "pupiltable.h"
+
+enum TestStatus { TEST_OK, TEST_INSUFFICIENT, MISSING_MAPPING, MISSING_PUPIL };
+inline const char* const kStatusNames[] = {"ok", "insufficient", "missing_mapping", "missing_pupil"};
+inline const char* const kHalfNames[] = {"before", "after"};
+inline const char* const kEyeNames[] = {"left", "right"};
+
+// All tests as columns, one entry per (index, window, eye)
+struct TestBatch {
+    std::vector<std::string> index;
+    std::vector<PupilHalf> half;
+    std::vector<CalibrationTable::Eye> eye;
+    std::vector<TestStatus> status;
+    std::vector<PupilSummary> actual;
+    std::vector<CalibrationTable::Entry> expected;
+    std::vector<double> t, df, p;
+};
+
+// t statistic and degrees of freedom of the two-sample test, false when it is undefined
+inline bool tStatistic(const PupilSummary& a, const CalibrationTable::Entry& e, bool welch, double& t, double& df) {
+    if (a.count < 2 || e.count < 2) return false; // Not enough data for t-test
+    double v1 = a.stdDev * a.stdDev / a.count, v2 = e.stdDev * e.stdDev / e.count;
+    if (v1 + v2 == 0) return false; // Avoid division by zero
+    t = (a.avgSize - e.avgSize) / sqrt(v1 + v2);
+    if (welch) df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (a.count - 1) + v2 * v2 / (e.count - 1));
+    else df = std::min(a.count, e.count) - 1;
+    return true;
+}
+
+// Two-tailed p-values of all defined tests in one pass over the t and df columns
+inline void twoSidedPValues(const std::vector<double>& t, const std::vector<double>& df, std::vector<double>& p) {
+    p.assign(t.size(), NAN);
+    for (size_t i = 0; i < t.size(); i++) {
+        if (std::isnan(t[i])) continue;
+        double x = df[i] / (df[i] + t[i] * t[i]);
+        p[i] = x >= 1 ? 1.0 : boost::math::ibeta(df[i] / 2, 0.5, x);
+    }
+}
+
+// "0.05,0.01" -> {0.05, 0.01}; throws on a malformed number
+inline std::vector<double> parseAlphas(const std::string& list) {
+    std::vector<double> alphas;
+    std::stringstream ss(list);
+    std::string item;
+    while (getline(ss, item, ','))
+        if (!item.empty()) alphas.push_back(stod(item));
+    return alphas;
+}
+
+// Sorted, distinct indices of either pupil table
+inline std::vector<std::string> pupilIndices(const std::vector<PupilRow>& leftRows, const std::vector<PupilRow>& rightRows) {
+    std::vector<std::string> indices;
+    for (const PupilRow& r : leftRows) indices.push_back(r.index);
+    for (const PupilRow& r : rightRows) indices.push_back(r.index);
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return indices;
+}
+
+// Every test of the given windows; mappings[k] is the calibration of indices[k], null
+// or empty when the index has none
+inline TestBatch runTTests(const std::vector<std::string>& indices, const std::vector<PupilRow>& leftRows,
+                           const std::vector<PupilRow>& rightRows, const std::vector<const CalibrationTable*>& mappings,
+                           const std::vector<PupilHalf>& halves, bool welch) {
+    TestBatch batch;
+    for (size_t k = 0; k < indices.size(); k++) {
+        const PupilRow* rows[2] = {findPupilRow(leftRows, indices[k]), findPupilRow(rightRows, indices[k])};
+        for (PupilHalf half : halves) {
+            for (CalibrationTable::Eye eye : {CalibrationTable::LEFT, CalibrationTable::RIGHT}) {
+                TestStatus status = TEST_OK;
+                PupilSummary actual = {NAN, NAN, 0, NAN};
+                CalibrationTable::Entry expected = {NAN, NAN, 0, NAN};
+                double t = NAN, df = NAN;
+                if (!mappings[k] || mappings[k]->empty()) {
+                    status = MISSING_MAPPING;
+                } else if (!rows[0] || !rows[1]) {
+                    status = MISSING_PUPIL;
+                } else {
+                    actual = rows[eye]->half[half];
+                    // Expected values from the closest luminance in the mapping
+                    expected = mappings[k]->nearest(eye, actual.luminance);
+                    if (!tStatistic(actual, expected, welch, t, df)) status = TEST_INSUFFICIENT;
+                }
+                batch.index.push_back(indices[k]);
+                batch.half.push_back(half);
+                batch.eye.push_back(eye);
+                batch.status.push_back(status);
+                batch.actual.push_back(actual);
+                batch.expected.push_back(expected);
+                batch.t.push_back(t);
+                batch.df.push_back(df);
+            }
+        }
+    }
+    twoSidedPValues(batch.t, batch.df, batch.p);
+    return batch;
+}
+
+// One tab-separated row per test, with a reject column per significance level
+inline void writeTestTable(std::ostream& out, const TestBatch& batch, const std::vector<double>& alphas) {
+    out << "index\twindow\teye\tstatus\tluminance\tmean\tsd\tn\texpectedMean\texpectedSd\texpectedN\tt\tdf\tp";
+    for (double a : alphas) out << "\treject_" << a;
+    out << '\n';
+    auto num = [&](double v) -> std::ostream& { return std::isnan(v) ? out << "NA" : out << v; };
+    for (size_t i = 0; i < batch.index.size(); i++) {
+        const PupilSummary& a = batch.actual[i];
+        const CalibrationTable::Entry& e = batch.expected[i];
+        out << batch.index[i] << '\t' << kHalfNames[batch.half[i]] << '\t' << kEyeNames[batch.eye[i]] << '\t'
+            << kStatusNames[batch.status[i]] << '\t';
+        num(a.luminance) << '\t';
+        num(a.avgSize) << '\t';
+        num(a.stdDev) << '\t' << a.count << '\t';
+        num(e.avgSize) << '\t';
+        num(e.stdDev) << '\t' << e.count << '\t';
+        num(batch.t[i]) << '\t';
+        num(batch.df[i]) << '\t';
+        num(batch.p[i]);
+        for (double alpha : alphas)
+            out << '\t' << (std::isnan(batch.p[i]) ? "NA" : batch.p[i] < alpha ? "1" : "0");
+        out << '\n';
+    }
+    out.flush();
+}
+
+// Pass counts of every window and level, in the layout of the interactive tools
+inline void printTestSummary(std::ostream& out, const TestBatch& batch, const std::vector<PupilHalf>& halves,
+                             const std::vector<double>& alphas, bool welch) {
+    for (PupilHalf half : halves) {
+        int missingMapping = 0, missingPupil = 0;
+        for (size_t i = 0; i < batch.index.size(); i++) {
+            if (batch.half[i] != half || batch.eye[i] != CalibrationTable::LEFT) continue;
+            if (batch.status[i] == MISSING_MAPPING) missingMapping++;
+            if (batch.status[i] == MISSING_PUPIL) missingPupil++;
+        }
+        out << "\n==== Summary (" << kHalfNames[half] << " event" << (welch ? ", Welch df" : "") << ") ====\n";
+        for (double alpha : alphas) {
+            int total[2] = {0, 0}, pass[2] = {0, 0};
+            for (size_t i = 0; i < batch.index.size(); i++) {
+                if (batch.half[i] != half || std::isnan(batch.p[i])) continue;
+                total[batch.eye[i]]++;
+                if (batch.p[i] < alpha) pass[batch.eye[i]]++;
+            }
+            out << "Significance Level: " << alpha << '\n';
+            out << "Left Passed: " << pass[0] << " / " << total[0] << " (" << (total[0] ? (pass[0] * 100.0 / total[0]) : 0) << "%)\n";
+            out << "Right Passed: " << pass[1] << " / " << total[1] << " (" << (total[1] ? (pass[1] * 100.0 / total[1]) : 0) << "%)\n";
+        }
+        out << "Missing Luminance Mapping: " << missingMapping << "\n";
+        out << "Missing Pupil Data: " << missingPupil << "\n";
+    }
+}
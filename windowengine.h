@@ -0,0 +1,671 @@
+// Before/after window analyses of the shook and noshook sessions.
+// Both conditions look at the 5 s leading up to the "0.2 seconds" tag. Shook sessions
+// compare them with the 5 s after the "shook" tag, noshook sessions (where the robot
+// never shakes) with the 5 s after the estimated event start 0.229 s past
+// "0.2 seconds". A Condition records exactly that, and one set of analyses serves both:
+//   PUPIL_AVERAGES -> leftpupil.txt / rightpupil.txt and the pupil report
+//   LUMINANCE      -> luminance/<index>luminance.txt
+//   PUPIL_SIZE     -> pupil size/<index>pupil.txt
+//   EVENT_TIMING   -> "0.2 seconds" to after-tag report (conditions with an after tag)
+//   LUMINANCE_VALUES -> the LUMINANCE windows kept in the SessionResult, no file
+// runWindowAnalyses() loads every session of the requested conditions once (through
+// the .cols sidecar), on one work-stealing pool, runs the requested analyses on it and
+// prints each condition's reports in index order; collectWindowResults() is the same
+// run without the reports, for callers that use the results in memory. shookpupil, noshookpupil,
+// luminanceshook, luminancenoshook, pupilsizeshook and pupilsizenoshook are front ends
+// for one condition and one analysis; sessionscan runs any mix of them. Results are
+// recorded in a manifest (manifest.h), so --incremental reruns only load new or changed
+// sessions, and --quiet / --binary select the output (resultsink.h).
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sessioncache.h"
+#include "parallel.h"
+#include "timewindow.h"
+#include "manifest.h"
+#include "resultsink.h"
+#include "stats.h"
+#include "pupiltable.h"
+
+// Where a condition's windows sit. The before window is anchored at the "0.2 seconds"
+// row, the after window at the afterTag row.
+struct Condition {
+    const char* name;          // input folder, also used in the messages
+    const char* afterTag;
+    TimeWindow before, after;
+    bool tagInAnyCell;         // search every cell for the tags instead of robotEvent
+    const char* pupilReport;   // title of the pupil report
+
+    // False when the after window hangs off the "0.2 seconds" tag as well
+    bool hasAfterEvent() const { return strcmp(afterTag, "0.2 seconds") != 0; }
+};
+
+inline const Condition kShook = {
+    "shook", "shook", TimeWindow::before(5.0), TimeWindow::after(5.0), false, "Pupil Analysis Report"};
+inline const Condition kNoshook = {
+    "noshook", "0.2 seconds", TimeWindow::before(5.0), TimeWindow::after(5.0, 0.229), true,
+    "Noshook Pupil Analysis Report"};
+
+enum WindowAnalysis {
+    PUPIL_AVERAGES = 1,
+    LUMINANCE = 2,
+    PUPIL_SIZE = 4,
+    EVENT_TIMING = 8,
+    LUMINANCE_VALUES = 16,
+};
+
+// One session with its event anchors located and its time column indexed
+class WindowSession {
+public:
+    WindowSession(const std::filesystem::path& csv, const Condition& cond)
+        : condition(cond),
+          fileIndex(csv.filename().string().substr(0, 5)),
+          data(csv.string()),
+          index(data.empty() ? nullptr : data.values(COL_TIME), data.rows()) {
+        if (data.empty()) return;
+        PROFILE_SCOPE("event lookup");
+        EventPatterns events({"0.2 seconds", cond.afterTag});
+        std::vector<EventHit> hits;
+        if (cond.tagInAnyCell) {
+            hits = data.timeline().find(events);
+        } else {
+            hits = data.findEvents(COL_ROBOT_EVENT, events);
+        }
+        row02 = hits[0].row;
+        rowAfter = hits[1].row;
+        const double* time = data.values(COL_TIME);
+        if (row02 >= 0) beforeTime = time[row02];
+        if (rowAfter >= 0) afterTime = time[rowAfter];
+    }
+
+    // Why the session cannot be analysed, empty when it can. needRight is false for
+    // analyses that only use luminance (its own column, or the one before leftPupil).
+    std::string problem(bool needRight = true) const {
+        if (data.empty()) return "Could not load CSV";
+        if (!needRight && data.column(COL_LUMINANCE) == -1) return "'luminance' column not found";
+        if (needRight && (data.column(COL_LEFT_PUPIL) == -1 || data.column(COL_RIGHT_PUPIL) == -1))
+            return "'leftPupil' or 'rightPupil' column not found";
+        if (!condition.tagInAnyCell && data.column(COL_ROBOT_EVENT) == -1) return "'robotEvent' column not found";
+        if (row02 == -1 || rowAfter == -1) {
+            if (!condition.hasAfterEvent()) return "'0.2 seconds' tag not found";
+            return std::string("'0.2 seconds' or '") + condition.afterTag + "' event not found";
+        }
+        if (std::isnan(beforeTime) || std::isnan(afterTime)) return "Invalid time value in event row";
+        return "";
+    }
+
+    // Rows of the before/after window, in row order
+    template <class Fn>
+    void forBefore(Fn fn) const { index.forEach(condition.before, beforeTime, fn); }
+    template <class Fn>
+    void forAfter(Fn fn) const { index.forEach(condition.after, afterTime, fn); }
+
+    const Condition& condition;
+    std::string fileIndex;
+    SessionColumns data;
+    TimeIndex index;
+    int row02 = -1, rowAfter = -1;        // data rows of the tags, -1 when missing
+    double beforeTime = NAN, afterTime = NAN;
+};
+
+// ---------- pupil averages ---------------------------------------------------
+
+inline double calculateStdDev(const RunningStats& values, double mean) {
+    if (values.count() < 2) return -1.0; // Standard deviation is undefined for n < 2
+    return sqrt(values.squaredDeviations(mean) / (values.count() - 1)); // Bessel's correction
+}
+
+// Samples of one window. Only positive pupil sizes and luminances count as valid.
+struct PupilWindow {
+    double sumLeft = 0, sumRight = 0, sumLum = 0, lumCount = 0, count = 0;
+    RunningStats left, right;
+    void add(double l, double r, double lu) {
+        if (l > 0) { sumLeft += l; left.add(l); }
+        if (r > 0) { sumRight += r; right.add(r); }
+        if (lu > 0) { sumLum += lu; lumCount++; }
+        count++;
+    }
+    // Average of the valid samples, -1 when fewer than half the rows were valid
+    double avg(double sum, double n) const { return (n >= count * 0.5) ? sum / n : -1; }
+};
+
+// average luminance before [0], average left before [1], left before size [2], sd left before [3],
+// average right before [4], right before size [5], sd right before [6],
+// average luminance after [7], average left after [8], leftafter size [9], sd left after [10],
+// average right after [11], rightafter size [12], sd right after [13]
+inline std::vector<double> pupilAverages(const WindowSession& s) {
+    PROFILE_SCOPE("pupil averages");
+    const SessionColumns& data = s.data;
+    const double* left = data.values(COL_LEFT_PUPIL);
+    const double* right = data.values(COL_RIGHT_PUPIL);
+    const double* lum = data.values(COL_LUMINANCE);
+    const uint32_t* cells = data.cellCounts();
+    uint32_t lastPupilCol = std::max(data.column(COL_LEFT_PUPIL), data.column(COL_RIGHT_PUPIL));
+    // Rows that are too short or have an unparsable cell are left out of both windows
+    auto usable = [&](size_t i) {
+        return cells[i] > lastPupilCol && !std::isnan(left[i]) && !std::isnan(right[i]) && !std::isnan(lum[i]);
+    };
+    PupilWindow before, after;
+    s.forBefore([&](size_t i) { if (usable(i)) before.add(left[i], right[i], lum[i]); });
+    s.forAfter([&](size_t i) { if (usable(i)) after.add(left[i], right[i], lum[i]); });
+
+    double avgLeftBefore = before.avg(before.sumLeft, before.left.count());
+    double avgRightBefore = before.avg(before.sumRight, before.right.count());
+    double avgLeftAfter = after.avg(after.sumLeft, after.left.count());
+    double avgRightAfter = after.avg(after.sumRight, after.right.count());
+    return {
+        before.avg(before.sumLum, before.lumCount),
+        avgLeftBefore, double(before.left.count()), calculateStdDev(before.left, avgLeftBefore),
+        avgRightBefore, double(before.right.count()), calculateStdDev(before.right, avgRightBefore),
+        after.avg(after.sumLum, after.lumCount),
+        avgLeftAfter, double(after.left.count()), calculateStdDev(after.left, avgLeftAfter),
+        // sd right after uses the before window, as the pupil tools have always written it
+        avgRightAfter, double(after.right.count()), calculateStdDev(before.right, avgRightBefore),
+    };
+}
+
+// Key of a session's rows in leftpupil.txt/rightpupil.txt: the index as a number
+inline std::string pupilRowKey(const std::string& fileIndex) {
+    std::ostringstream key;
+    key << stod(fileIndex);
+    return key.str();
+}
+
+// Columns of leftpupil.txt/rightpupil.txt; n & sd is only for pupil size after, not before
+inline const std::vector<std::string> kPupilColumns = {
+    "index", "luminanceBefore", "pupilBefore", "nBefore", "sdBefore",
+    "luminanceAfter", "pupilAfter", "nAfter", "sdAfter"};
+
+// Whether pupilAverages() output d goes into the pupil tables at all (an average
+// luminance in either window), and whether eye (0 left, 1 right) has both averages
+inline bool validLuminance(const std::vector<double>& d) { return d[0] > 0 || d[7] > 0; }
+inline bool validEye(const std::vector<double>& d, int eye) {
+    int o = eye ? 4 : 1;
+    return d[o] >= 0 && d[o + 7] >= 0;
+}
+// Row of eye in leftpupil.txt/rightpupil.txt, without the index cell
+inline std::vector<double> pupilTableRow(const std::vector<double>& d, int eye) {
+    int o = eye ? 4 : 1;
+    return {d[0], d[o], d[o + 1], d[o + 2], d[7], d[o + 7], d[o + 8], d[o + 9]};
+}
+
+// ---------- window dumps -----------------------------------------------------
+
+// Luminances of the before and after windows, appended in row order. Invalid (-1)
+// values are excluded. Returns why the session has no windows, empty when it has.
+inline std::string windowLuminances(const WindowSession& s, std::vector<double>& before, std::vector<double>& after) {
+    std::string why = s.problem(false);
+    if (!why.empty()) return why;
+    const double* lum = s.data.values(COL_LUMINANCE);
+    const uint32_t* cells = s.data.cellCounts();
+    uint32_t luminanceCol = std::max(s.data.column(COL_LUMINANCE), 0);
+    auto usable = [&](size_t i) { return cells[i] > luminanceCol && !std::isnan(lum[i]) && lum[i] != -1; };
+    s.forBefore([&](size_t i) { if (usable(i)) before.push_back(lum[i]); });
+    s.forAfter([&](size_t i) { if (usable(i)) after.push_back(lum[i]); });
+    return "";
+}
+
+// luminance/<index>luminance.txt: the before-window luminances, an empty line, then the
+// after-window ones (windowLuminances()).
+inline std::string dumpLuminance(const WindowSession& s, const std::filesystem::path& folder, bool& written) {
+    PROFILE_SCOPE("luminance dump");
+    std::ostringstream log;
+    log << "Extracting luminance level of file " << s.fileIndex << std::endl;
+    Scratch<double> beforeBuf, afterBuf;
+    std::vector<double>& before = *beforeBuf;
+    std::vector<double>& after = *afterBuf;
+    std::string why = windowLuminances(s, before, after);
+    if (!why.empty()) {
+        log << "Index " << s.fileIndex << " -> ERROR: " << why << " ❌" << std::endl;
+        return log.str();
+    }
+
+    std::string outFileName = (folder / (s.fileIndex + "luminance.txt")).string();
+    std::ofstream outFile(outFileName);
+    if (!outFile) {
+        std::cerr << "Error: Could not open file " << outFileName << " for writing." << std::endl;
+        return log.str();
+    }
+    for (double val : before) outFile << val << "\n";
+    outFile << "\n";
+    for (double val : after) outFile << val << "\n";
+    outFile.close();
+    written = true;
+    log << "Finished processing file " << s.fileIndex << std::endl;
+    return log.str();
+}
+
+// pupil size/<index>pupil.txt: "left right" pairs of the before window, an empty line,
+// then the after window. -1 samples are kept on purpose.
+inline std::string dumpPupilSize(const WindowSession& s, const std::filesystem::path& folder, bool& written) {
+    PROFILE_SCOPE("pupil size dump");
+    std::ostringstream log;
+    log << "Extracting pupil size data for file " << s.fileIndex << std::endl;
+    std::string why = s.problem();
+    if (!why.empty()) {
+        log << "Index " << s.fileIndex << " -> ERROR: " << why << " ❌" << std::endl;
+        return log.str();
+    }
+    const double* left = s.data.values(COL_LEFT_PUPIL);
+    const double* right = s.data.values(COL_RIGHT_PUPIL);
+    const uint32_t* cells = s.data.cellCounts();
+    uint32_t lastPupilCol = std::max(s.data.column(COL_LEFT_PUPIL), s.data.column(COL_RIGHT_PUPIL));
+    Scratch<std::pair<double, double>> beforeBuf, afterBuf;
+    std::vector<std::pair<double, double>>& before = *beforeBuf;
+    std::vector<std::pair<double, double>>& after = *afterBuf;
+    auto usable = [&](size_t i) { return cells[i] > lastPupilCol && !std::isnan(left[i]) && !std::isnan(right[i]); };
+    s.forBefore([&](size_t i) { if (usable(i)) before.push_back({left[i], right[i]}); });
+    s.forAfter([&](size_t i) { if (usable(i)) after.push_back({left[i], right[i]}); });
+
+    std::string outFileName = (folder / (s.fileIndex + "pupil.txt")).string();
+    std::ofstream outFile(outFileName);
+    if (!outFile) {
+        std::cerr << "Error: Could not open file " << outFileName << " for writing." << std::endl;
+        return log.str();
+    }
+    for (const auto& p : before) outFile << p.first << " " << p.second << "\n";
+    outFile << "\n";
+    for (const auto& p : after) outFile << p.first << " " << p.second << "\n";
+    outFile.close();
+    written = true;
+    log << "Finished processing file " << s.fileIndex << std::endl;
+    return log.str();
+}
+
+// ---------- driver -----------------------------------------------------------
+
+// Everything the analyses produced for one session, merged in index order
+struct SessionResult {
+    std::string fileIndex;
+    std::string signature;             // manifest signature of the input
+    unsigned reused = 0;               // analyses restored from the manifest
+    bool missing02 = false;            // no "0.2 seconds" tag
+    std::string pupilLog;              // error line of the pupil report
+    std::vector<double> averages;      // pupilAverages(), empty when skipped
+    std::string luminanceLog, pupilSizeLog, timingLog;
+    bool luminanceWritten = false, pupilSizeWritten = false;
+    double timeDifference = -1;        // after tag minus "0.2 seconds", -1 when invalid
+    bool luminanceKept = false;        // LUMINANCE_VALUES: the windows were found
+    std::vector<double> luminance[2];  // [BEFORE_EVENT], [AFTER_EVENT] window luminances
+};
+
+inline SessionResult analyzeSession(const std::filesystem::path& csv, const Condition& cond, unsigned analyses) {
+    PROFILE_FILE("session", csv.filename().string());
+    WindowSession s(csv, cond);
+    SessionResult res;
+    res.fileIndex = s.fileIndex;
+    res.missing02 = !s.data.empty() && s.row02 == -1;
+    if (analyses & PUPIL_AVERAGES) {
+        std::string why = s.problem();
+        if (why.empty()) res.averages = pupilAverages(s);
+        else res.pupilLog = "Index " + s.fileIndex + " -> ERROR: " + why + " ❌\n";
+    }
+    if (analyses & LUMINANCE) res.luminanceLog = dumpLuminance(s, "luminance", res.luminanceWritten);
+    if (analyses & LUMINANCE_VALUES)
+        res.luminanceKept = windowLuminances(s, res.luminance[BEFORE_EVENT], res.luminance[AFTER_EVENT]).empty();
+    if (analyses & PUPIL_SIZE) res.pupilSizeLog = dumpPupilSize(s, "pupil size", res.pupilSizeWritten);
+    if ((analyses & EVENT_TIMING) && cond.hasAfterEvent()) {
+        // Rows whose time did not parse are passed over when looking for the tags
+        std::ostringstream log;
+        log << std::fixed << std::setprecision(3);
+        if (s.data.empty()) {
+            log << "Index " << s.fileIndex << " -> ERROR: Could not load CSV ❌" << std::endl;
+        } else if (s.data.column(COL_ROBOT_EVENT) == -1) {
+            log << "Index " << s.fileIndex << " -> ERROR: 'robotEvent' column not found ❌" << std::endl;
+        } else {
+            EventPatterns events({"0.2 seconds", cond.afterTag});
+            const double* time = s.data.values(COL_TIME);
+            std::vector<EventHit> hits =
+                s.data.findEvents(COL_ROBOT_EVENT, events, [&](size_t i) { return !std::isnan(time[i]); });
+            if (!hits[0].found() || !hits[1].found() || hits[0].time > hits[1].time) {
+                log << "Index " << s.fileIndex << " -> ERROR ❌" << std::endl;
+            } else {
+                res.timeDifference = hits[1].time - hits[0].time;
+                log << "Index " << s.fileIndex << ", \"0.2 seconds\": " << hits[0].time << ", \"" << cond.afterTag
+                    << "\": " << hits[1].time << ", Time Difference: " << res.timeDifference << std::endl;
+            }
+        }
+        res.timingLog = log.str();
+    }
+    return res;
+}
+
+// ---------- manifest payloads ------------------------------------------------
+// What one analysis of one session leaves in the manifest: a first line of numbers
+// (doubles in round-trip precision) followed by the analysis' log lines.
+
+const struct {
+    WindowAnalysis analysis;
+    const char* name;
+} kWindowAnalyses[] = {
+    {PUPIL_AVERAGES, "pupil"}, {LUMINANCE, "luminance"}, {PUPIL_SIZE, "pupilsize"}, {EVENT_TIMING, "timing"},
+};
+
+// Settings a recorded result depends on besides the input file
+inline std::string conditionConfig(const Condition& cond) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s|%.17g,%.17g,%.17g|%.17g,%.17g,%.17g|%d", cond.afterTag, cond.before.offset,
+             cond.before.from, cond.before.to, cond.after.offset, cond.after.from, cond.after.to, cond.tagInAnyCell);
+    return buf;
+}
+
+inline std::string savePayload(const SessionResult& res, WindowAnalysis a) {
+    std::ostringstream out;
+    out << std::setprecision(17);
+    switch (a) {
+    case PUPIL_AVERAGES:
+        out << res.missing02;
+        for (double v : res.averages) out << ' ' << v;
+        out << '\n' << res.pupilLog;
+        break;
+    case LUMINANCE: out << res.luminanceWritten << '\n' << res.luminanceLog; break;
+    case PUPIL_SIZE: out << res.pupilSizeWritten << '\n' << res.pupilSizeLog; break;
+    case EVENT_TIMING: out << res.timeDifference << '\n' << res.timingLog; break;
+    default: break;   // LUMINANCE_VALUES is not recorded
+    }
+    return out.str();
+}
+
+// Restore analysis a into res; false when the output file it wrote has gone missing
+inline bool loadPayload(const std::string& payload, WindowAnalysis a, const std::string& fileIndex, SessionResult& res) {
+    size_t nl = payload.find('\n');
+    std::istringstream first(payload.substr(0, nl));
+    std::string log = nl == std::string::npos ? "" : payload.substr(nl + 1);
+    namespace fs = std::filesystem;
+    switch (a) {
+    case PUPIL_AVERAGES: {
+        first >> res.missing02;
+        std::string v;
+        while (first >> v) res.averages.push_back(strtod(v.c_str(), nullptr));   // keeps nan
+        res.pupilLog = log;
+        return true;
+    }
+    case LUMINANCE:
+        first >> res.luminanceWritten;
+        res.luminanceLog = log;
+        return !res.luminanceWritten || fs::exists(fs::path("luminance") / (fileIndex + "luminance.txt"));
+    case PUPIL_SIZE:
+        first >> res.pupilSizeWritten;
+        res.pupilSizeLog = log;
+        return !res.pupilSizeWritten || fs::exists(fs::path("pupil size") / (fileIndex + "pupil.txt"));
+    case EVENT_TIMING:
+        first >> res.timeDifference;
+        res.timingLog = log;
+        return true;
+    default: return false;
+    }
+}
+
+// ---------- reports ----------------------------------------------------------
+
+// Pupil report of one condition, to out. The valid eyes replace their index's rows in
+// leftpupil.txt/rightpupil.txt, and rows of sessions that no longer qualify are removed;
+// with saveTables false the files are left alone.
+inline void printPupilReport(std::ostream& out, const Condition& cond, const std::vector<const SessionResult*>& results,
+                             const SinkOptions& output, bool saveTables = true) {
+    out << "\n==== " << cond.pupilReport << " ====\n";
+    int validleftcnt = 0, validrightcnt = 0, totalcnt = results.size();
+    double leftbefore = 0, leftafter = 0, rightbefore = 0, rightafter = 0;
+    int invalidluminancecnt = 0;
+    std::vector<std::string> invalidluminance;
+    std::set<std::string> missingEventIndices;
+    ResultTable leftTable("leftpupil.txt", kPupilColumns), rightTable("rightpupil.txt", kPupilColumns);
+    for (const SessionResult* res : results) {
+        printProgress(out, res->pupilLog, output.quiet);
+        if (res->missing02) missingEventIndices.insert(res->fileIndex);
+        const std::string& fileIndex = res->fileIndex;
+        const std::vector<double>& datalist = res->averages;
+        std::string key;
+        try { key = pupilRowKey(fileIndex); } catch (...) { PROFILE_COUNT(PROF_PARSE_FAILURES, 1); }
+        if (!key.empty()) leftTable.erase(key), rightTable.erase(key);
+        if (res->averages.empty()) continue;
+
+        std::ostringstream line;
+        line << "Index " << fileIndex << " -> ";
+        if (validLuminance(datalist)){ //average luminance check
+            if (!validEye(datalist, 0)) { //left eye before & after
+                line << "invalid left eye ❌, ";
+            } else {
+                line << "Valid left eye ✅ ";
+                leftbefore += datalist[1];
+                leftafter += datalist[8];
+                validleftcnt++;
+                leftTable.set(key, pupilTableRow(datalist, 0));
+                line << "Data saved to leftpupil.txt";
+            }
+            if (!validEye(datalist, 1)) { //right eye before & after
+                line << "invalid right eye ❌, " << '\n';
+            } else {
+                line << "Valid right eye ✅ " << '\n';
+                rightbefore += datalist[4];
+                rightafter += datalist[11];
+                validrightcnt++;
+                rightTable.set(key, pupilTableRow(datalist, 1));
+                line << "Data saved to rightpupil.txt";
+            }
+        }
+        else{
+            invalidluminancecnt++;
+            invalidluminance.push_back(fileIndex);
+            line<<"Invalid luminance";
+        }
+        line<<'\n';
+        printProgress(out, line.str(), output.quiet);
+    }
+    if (saveTables) {
+        PROFILE_SCOPE("pupil table write");
+        leftTable.flush(output);
+        rightTable.flush(output);
+    }
+
+    out << "\n==== Indices with Missing '0.2 seconds' Tag ====\n";
+    for (const auto& index : missingEventIndices) {
+        out << index << " ";
+    }
+    out << "\n\nValid left count: " << validleftcnt << " / " << totalcnt;
+    out << ", Valid right count: " << validrightcnt << " / " << totalcnt << '\n';
+    out << "Avg Left Before: " << leftbefore / validleftcnt << ", Avg Left After: " << leftafter / validleftcnt;
+    out << ", Avg Left Diff: " << (leftafter - leftbefore) / validleftcnt << '\n';
+    out << "Avg Right Before: " << rightbefore / validrightcnt << ", Avg Right After: " << rightafter / validrightcnt;
+    out << ", Avg Right Diff: " << (rightafter - rightbefore) / validrightcnt << '\n';
+    out << "Invalid luminance cnt "<<invalidluminancecnt<<" "<<(totalcnt ? invalidluminancecnt/totalcnt : 0)<<'\n';
+    if (invalidluminance.size()){
+        out << "Invalid luminance: ";
+        for (const std::string& index : invalidluminance) out << index << " ";
+        out<<'\n';
+    }
+    else{
+        out<<"No Invalid Luminance"<<'\n';
+    }
+}
+
+inline void printTimingReport(std::ostream& out, const std::vector<const SessionResult*>& results,
+                              const SinkOptions& output) {
+    RunningStats timeDifferences;
+    for (const SessionResult* res : results) {
+        printProgress(out, res->timingLog, output.quiet);
+        if (res->timeDifference != -1) timeDifferences.add(res->timeDifference);
+    }
+    if (timeDifferences.empty()) {
+        out << "\nNo valid time differences found. Unable to calculate mean and variance.\n";
+        return;
+    }
+    out << "count: " << timeDifferences.count() << '\n';
+    out << "\n==== Statistical Analysis ====\n";
+    out << "Mean Time Difference: " << timeDifferences.mean() << std::endl;
+    out << "Variance of Time Difference: " << timeDifferences.populationVariance() << std::endl; // Population variance
+}
+
+// Options of a run: thread count, --incremental, and --quiet/--binary output
+struct WindowRunOptions {
+    int threads = 1;
+    bool incremental = false;
+    SinkOptions output;
+};
+
+inline WindowRunOptions parseWindowRunOptions(int argc, char** argv) {
+    return {parseThreads(argc, argv), parseIncremental(argc, argv), parseSinkOptions(argc, argv)};
+}
+
+// Sessions of every condition with their results, in condition then index order
+struct WindowRun {
+    std::vector<const Condition*> conditions;
+    std::vector<SessionResult> results;
+    std::vector<size_t> firstJob;      // condition c has results [firstJob[c], firstJob[c + 1])
+    size_t reused = 0;                 // sessions restored from the manifest
+
+    std::vector<const SessionResult*> of(size_t c) const {
+        std::vector<const SessionResult*> mine;
+        for (size_t k = firstJob[c]; k < firstJob[c + 1]; k++) mine.push_back(&results[k]);
+        return mine;
+    }
+};
+
+// Run the analyses over the folder of every condition, without any report. All
+// sessions of all conditions share one pool. Every run records its results in
+// .manifest/<condition>-<analysis>; with incremental set, sessions whose CSV is
+// unchanged since then are not loaded again (LUMINANCE_VALUES are not recorded, so
+// asking for them always loads the session). Returns 1 when a condition's folder is
+// missing.
+inline int collectWindowResults(const std::vector<const Condition*>& conditions, unsigned analyses,
+                                const WindowRunOptions& options, WindowRun& run, std::ostream& out = std::cout) {
+    namespace fs = std::filesystem;
+    bool incremental = options.incremental;
+    if ((analyses & LUMINANCE) && !fs::exists("luminance")) fs::create_directory("luminance");
+    if ((analyses & PUPIL_SIZE) && !fs::exists("pupil size")) fs::create_directory("pupil size");
+
+    struct Job {
+        size_t cond;
+        fs::path csv;
+    };
+    std::vector<Job> jobs;
+    run = WindowRun();
+    run.conditions = conditions;
+    std::vector<std::vector<Manifest>> manifests(conditions.size());   // [condition][analysis]
+    for (size_t c = 0; c < conditions.size(); c++) {
+        const Condition* cond = conditions[c];
+        fs::path folder = fs::path(".") / cond->name;
+        if (!fs::exists(folder) || !fs::is_directory(folder)) {
+            out << "Scanning CSV files in the " << cond->name << " folder..." << std::endl;
+            std::cerr << "Error: '" << cond->name << "' folder does not exist!" << std::endl;
+            return 1;
+        }
+        for (const auto& a : kWindowAnalyses) manifests[c].emplace_back(std::string(cond->name) + "-" + a.name);
+        run.firstJob.push_back(jobs.size());
+        for (const fs::path& csv : indexedFiles(folder, ".csv")) jobs.push_back({c, csv});
+    }
+    run.firstJob.push_back(jobs.size());
+
+    run.results = parallelMap<SessionResult>(jobs.size(), options.threads, [&](size_t k) {
+        const Condition& cond = *conditions[jobs[k].cond];
+        const std::vector<Manifest>& manifest = manifests[jobs[k].cond];
+        std::string key = jobs[k].csv.filename().string();
+        std::string sig = Manifest::signature({jobs[k].csv}, conditionConfig(cond));
+        SessionResult restored;
+        unsigned todo = analyses;
+        for (size_t a = 0; incremental && a < manifest.size(); a++) {
+            WindowAnalysis analysis = kWindowAnalyses[a].analysis;
+            if (!(analyses & analysis)) continue;
+            const std::string* payload = manifest[a].lookup(key, sig);
+            if (payload && loadPayload(*payload, analysis, key.substr(0, 5), restored)) todo &= ~analysis;
+        }
+        SessionResult res = todo ? analyzeSession(jobs[k].csv, cond, todo) : SessionResult();
+        res.fileIndex = key.substr(0, 5);
+        res.signature = sig;
+        res.reused = analyses & ~todo;
+        if (res.reused & PUPIL_AVERAGES) {
+            res.missing02 = restored.missing02;
+            res.averages = restored.averages;
+            res.pupilLog = restored.pupilLog;
+        }
+        if (res.reused & LUMINANCE) res.luminanceLog = restored.luminanceLog, res.luminanceWritten = restored.luminanceWritten;
+        if (res.reused & PUPIL_SIZE) res.pupilSizeLog = restored.pupilSizeLog, res.pupilSizeWritten = restored.pupilSizeWritten;
+        if (res.reused & EVENT_TIMING) res.timingLog = restored.timingLog, res.timeDifference = restored.timeDifference;
+        return res;
+    });
+
+    // Timing only exists for conditions with an after tag
+    auto runs = [&](size_t c, size_t a) {
+        WindowAnalysis analysis = kWindowAnalyses[a].analysis;
+        return (analyses & analysis) && (analysis != EVENT_TIMING || conditions[c]->hasAfterEvent());
+    };
+    for (size_t k = 0; k < jobs.size(); k++) {
+        std::vector<Manifest>& manifest = manifests[jobs[k].cond];
+        if (run.results[k].reused == analyses) run.reused++;
+        for (size_t a = 0; a < manifest.size(); a++) {
+            WindowAnalysis analysis = kWindowAnalyses[a].analysis;
+            if (runs(jobs[k].cond, a))
+                manifest[a].record(jobs[k].csv.filename().string(), run.results[k].signature,
+                                   savePayload(run.results[k], analysis));
+        }
+    }
+    PROFILE_SCOPE("manifest save");
+    for (size_t c = 0; c < conditions.size(); c++)
+        for (size_t a = 0; a < manifests[c].size(); a++)
+            if (runs(c, a)) manifests[c][a].save();
+    return 0;
+}
+
+// leftpupil.txt / rightpupil.txt as the pupil reports of a run would leave them, without
+// the rows earlier runs left in the files: rows[0] left, rows[1] right, sorted by index
+// as readPupilTable() returns them. A later condition's row of an index replaces an
+// earlier one's.
+inline void collectPupilRows(const WindowRun& run, std::vector<PupilRow> rows[2]) {
+    std::map<std::string, PupilRow> eyes[2];
+    for (const SessionResult& res : run.results) {
+        std::string key;
+        try { key = pupilRowKey(res.fileIndex); } catch (...) { continue; }
+        eyes[0].erase(key), eyes[1].erase(key);
+        if (res.averages.empty() || !validLuminance(res.averages)) continue;
+        for (int eye = 0; eye < 2; eye++) {
+            if (!validEye(res.averages, eye)) continue;
+            std::vector<double> v = pupilTableRow(res.averages, eye);
+            PupilRow& r = eyes[eye][key];
+            r.index = key;
+            r.half[BEFORE_EVENT] = {v[0], v[1], (int)v[2], v[3]};
+            r.half[AFTER_EVENT] = {v[4], v[5], (int)v[6], v[7]};
+        }
+    }
+    for (int eye = 0; eye < 2; eye++) {
+        rows[eye].clear();
+        for (const auto& entry : eyes[eye]) rows[eye].push_back(entry.second);
+    }
+}
+
+// Run the analyses over the folder of every condition (collectWindowResults()), then
+// print the reports condition by condition, in index order. Returns 1 when a
+// condition's folder is missing.
+inline int runWindowAnalyses(const std::vector<const Condition*>& conditions, unsigned analyses,
+                             const WindowRunOptions& options) {
+    bool quiet = options.output.quiet;
+    std::cout << std::fixed << std::setprecision(3);
+    WindowRun run;
+    if (collectWindowResults(conditions, analyses, options, run)) return 1;
+    for (size_t c = 0; c < conditions.size(); c++) {
+        std::vector<const SessionResult*> mine = run.of(c);
+        std::cout << "Scanning CSV files in the " << conditions[c]->name << " folder..." << std::endl;
+        if (analyses & PUPIL_AVERAGES) printPupilReport(std::cout, *conditions[c], mine, options.output);
+        if (analyses & LUMINANCE) {
+            for (const SessionResult* res : mine) printProgress(std::cout, res->luminanceLog, quiet);
+            std::cout << "Luminance extraction complete." << std::endl;
+        }
+        if (analyses & PUPIL_SIZE) {
+            for (const SessionResult* res : mine) printProgress(std::cout, res->pupilSizeLog, quiet);
+            std::cout << "Pupil size extraction complete." << std::endl;
+        }
+        if ((analyses & EVENT_TIMING) && conditions[c]->hasAfterEvent()) printTimingReport(std::cout, mine, options.output);
+    }
+    if (options.incremental)
+        std::cerr << "Incremental: " << run.reused << " of " << run.results.size() << " sessions unchanged" << std::endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Pupil and luminance statistics of arbitrary windows of a loaded session.
+// WindowPrefix builds prefix sums of a session's usable pupil and luminance samples
+// once; every window after that costs two binary searches over the time column,
+// however many are asked for. windowsweep sweeps a grid of windows with it, analysisd
+// answers window queries on its cached sessions.
+// Averages follow the pupil tools: only positive samples count, and the average is -1
+// when fewer than half the window's rows are valid. sd is about the window mean, -1
+// below two samples.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "windowengine.h"
+
+// Prefix sums over the rows of a session: entry i covers rows [0, i)
+class WindowPrefix {
+public:
+    enum Sum { ROWS, LUM_N, LUM_SUM, LEFT_N, LEFT_SUM, LEFT_SQ, RIGHT_N, RIGHT_SUM, RIGHT_SQ, NUM_SUMS };
+    struct Window {
+        double s[NUM_SUMS] = {};
+    };
+
+    explicit WindowPrefix(const WindowSession& s) : session_(s) {
+        const SessionColumns& data = s.data;
+        const double* time = data.values(COL_TIME);
+        left_ = data.values(COL_LEFT_PUPIL);
+        right_ = data.values(COL_RIGHT_PUPIL);
+        lum_ = data.values(COL_LUMINANCE);
+        size_t rows = data.rows();
+        const uint32_t* cells = data.cellCounts();
+        uint32_t lastPupilCol = std::max(data.column(COL_LEFT_PUPIL), data.column(COL_RIGHT_PUPIL));
+        usable_.resize(rows);
+        // Squares are taken about the session's mean pupil size, which keeps the
+        // sum-of-squares variance from cancelling out
+        RunningStats l, r;
+        for (size_t i = 0; i < rows; i++) {
+            usable_[i] = cells[i] > lastPupilCol && !std::isnan(time[i]) && !std::isnan(left_[i]) &&
+                         !std::isnan(right_[i]) && !std::isnan(lum_[i]);
+            if (!usable_[i]) continue;
+            if (left_[i] > 0) l.add(left_[i]);
+            if (right_[i] > 0) r.add(right_[i]);
+        }
+        shift_[0] = l.mean();
+        shift_[1] = r.mean();
+        if (!s.index.monotonic()) return;   // windows are summed row by row instead
+        for (auto& v : sums_) v.assign(rows + 1, 0.0);
+        for (size_t i = 0; i < rows; i++) {
+            Window w;
+            if (usable_[i]) sample(i, w);
+            for (int k = 0; k < NUM_SUMS; k++) sums_[k][i + 1] = sums_[k][i] + w.s[k];
+        }
+    }
+
+    Window window(double lo, double hi) const {
+        Window w;
+        if (sums_[0].empty()) {
+            session_.index.forEach(lo, hi, [&](size_t i) { if (usable_[i]) sample(i, w); });
+            return w;
+        }
+        auto [first, last] = session_.index.range(lo, hi);
+        for (int k = 0; k < NUM_SUMS; k++) w.s[k] = sums_[k][last] - sums_[k][first];
+        return w;
+    }
+
+    double shift(int eye) const { return shift_[eye]; }
+
+private:
+    void sample(size_t i, Window& w) const {
+        w.s[ROWS]++;
+        if (lum_[i] > 0) w.s[LUM_N]++, w.s[LUM_SUM] += lum_[i];
+        if (left_[i] > 0) {
+            double d = left_[i] - shift_[0];
+            w.s[LEFT_N]++, w.s[LEFT_SUM] += d, w.s[LEFT_SQ] += d * d;
+        }
+        if (right_[i] > 0) {
+            double d = right_[i] - shift_[1];
+            w.s[RIGHT_N]++, w.s[RIGHT_SUM] += d, w.s[RIGHT_SQ] += d * d;
+        }
+    }
+
+    const WindowSession& session_;
+    const double *left_, *right_, *lum_;
+    std::vector<char> usable_;
+    double shift_[2];
+    std::vector<double> sums_[NUM_SUMS];
+};
+
+// One window's statistics; pupil/n/sd are [left, right]
+struct WindowStats {
+    double rows = 0, luminance = -1;
+    double pupil[2] = {-1, -1}, n[2] = {0, 0}, sd[2] = {-1, -1};
+};
+
+// The window length seconds before (or after) the session's anchor moved by offset;
+// before windows hang off "0.2 seconds", after windows off the condition's after tag
+inline WindowStats windowStats(const WindowSession& s, const WindowPrefix& prefix, bool after, double offset,
+                               double length) {
+    TimeWindow tw = after ? TimeWindow::after(length, offset) : TimeWindow::before(length, offset);
+    double t = after ? s.afterTime : s.beforeTime;
+    WindowPrefix::Window w = prefix.window(tw.lo(t), tw.hi(t));
+    WindowStats st;
+    st.rows = w.s[WindowPrefix::ROWS];
+    auto avg = [&](double sum, double n, double shift) { return n > 0 && n >= st.rows * 0.5 ? shift + sum / n : -1; };
+    auto sd = [&](double sum, double sq, double n) {
+        return n < 2 ? -1 : std::sqrt(std::max(0.0, (sq - sum * sum / n) / (n - 1)));
+    };
+    st.luminance = avg(w.s[WindowPrefix::LUM_SUM], w.s[WindowPrefix::LUM_N], 0);
+    const int n[2] = {WindowPrefix::LEFT_N, WindowPrefix::RIGHT_N};
+    for (int eye = 0; eye < 2; eye++) {
+        double cnt = w.s[n[eye]], sum = w.s[n[eye] + 1], sq = w.s[n[eye] + 2];
+        st.pupil[eye] = avg(sum, cnt, prefix.shift(eye));
+        st.n[eye] = cnt;
+        st.sd[eye] = sd(sum, sq, cnt);
+    }
+    return st;
+}
@@ -0,0 +1,159 @@
+// Sensitivity sweep over window offsets and lengths.
+// The pupil tools look at one fixed pair of windows per condition (5 s before the
+// "0.2 seconds" tag, 5 s after "shook" or 0.229 s after the tag). This tool loads each
+// session once, builds prefix sums of its usable pupil and luminance samples
+// (windowprefix.h), and then answers every window of a whole grid with two binary
+// searches, so hundreds of configurations take about as long as one.
+// Windows are given as "before|after offset length" lines in a --grid file (the
+// pre-registered list), or as the product of --offsets and --lengths for both sides.
+// Output is one long-format row per condition, index, side, offset and length,
+// written to sweep.tsv (or -o).
+//g++ -std=c++17 -O2 windowsweep.cpp -o windowsweep -pthread
+//usage: ./windowsweep [--grid file] [--offsets 0,0.229] [--lengths 1,2,5] [--condition shook|noshook|both] [-o sweep.tsv] [-j threads]
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "windowprefix.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+struct SweepWindow {
+    bool after;                 // anchored at the after tag instead of "0.2 seconds"
+    double offset, length;
+};
+
+// Rows "before|after offset length"; '#' starts a comment
+bool readGrid(const string& filename, vector<SweepWindow>& grid) {
+    ifstream in(filename);
+    if (!in) {
+        cerr << "Error: Could not open file " << filename << endl;
+        return false;
+    }
+    string line;
+    int lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        istringstream ss(line);
+        string side;
+        SweepWindow w;
+        if (!(ss >> side >> w.offset >> w.length) || (side != "before" && side != "after") || !(w.length > 0)) {
+            cerr << "Error: " << filename << ":" << lineNo << ": expected 'before|after offset length'" << endl;
+            return false;
+        }
+        w.after = side == "after";
+        grid.push_back(w);
+    }
+    return true;
+}
+
+vector<double> parseList(const string& list) {
+    vector<double> values;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty()) values.push_back(stod(item));
+    return values;
+}
+
+// Long-format rows of one session, empty with the reason in err when it cannot be used
+string sweepSession(const fs::path& csv, const Condition& cond, const vector<SweepWindow>& grid, string& err) {
+    WindowSession s(csv, cond);
+    string why = s.problem();
+    if (!why.empty()) {
+        err = "Skipping " + csv.filename().string() + ": " + why + "\n";
+        return "";
+    }
+    WindowPrefix prefix(s);
+    ostringstream out;
+    for (const SweepWindow& g : grid) {
+        WindowStats w = windowStats(s, prefix, g.after, g.offset, g.length);
+        out << cond.name << '\t' << s.fileIndex << '\t' << (g.after ? "after" : "before") << '\t' << g.offset << '\t'
+            << g.length << '\t' << w.rows << '\t' << w.luminance;
+        for (int eye = 0; eye < 2; eye++) out << '\t' << w.pupil[eye] << '\t' << w.n[eye] << '\t' << w.sd[eye];
+        out << '\n';
+    }
+    return out.str();
+}
+
+int main(int argc, char** argv) {
+    ios_base::sync_with_stdio(0);
+    cin.tie(0);
+
+    vector<SweepWindow> grid;
+    vector<double> offsets = {0}, lengths;
+    vector<const Condition*> conditions = {&kShook, &kNoshook};
+    string outName = "sweep.tsv";
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--grid" && i + 1 < argc) {
+                if (!readGrid(argv[++i], grid)) return 1;
+            } else if (arg == "--offsets" && i + 1 < argc) {
+                offsets = parseList(argv[++i]);
+            } else if (arg == "--lengths" && i + 1 < argc) {
+                lengths = parseList(argv[++i]);
+            } else if (arg == "-o" && i + 1 < argc) {
+                outName = argv[++i];
+            } else if (arg == "--condition" && i + 1 < argc) {
+                string c = argv[++i];
+                if (c == "shook") conditions = {&kShook};
+                else if (c == "noshook") conditions = {&kNoshook};
+                else if (c == "both") conditions = {&kShook, &kNoshook};
+                else {
+                    cerr << "Error: unknown condition '" << c << "' (shook, noshook, both)" << endl;
+                    return 1;
+                }
+            }
+        }
+    } catch (...) {
+        cerr << "Error: --offsets and --lengths take comma-separated lists of numbers" << endl;
+        return 1;
+    }
+    for (double len : lengths)
+        for (double off : offsets)
+            if (len > 0) grid.push_back({false, off, len}), grid.push_back({true, off, len});
+    if (grid.empty()) {
+        cerr << "Error: no windows given (--grid file, or --lengths with optional --offsets)" << endl;
+        return 1;
+    }
+    int threads = parseThreads(argc, argv);
+
+    struct Job {
+        const Condition* cond;
+        fs::path csv;
+    };
+    vector<Job> jobs;
+    for (const Condition* cond : conditions) {
+        fs::path folder = fs::path(".") / cond->name;
+        if (!fs::exists(folder) || !fs::is_directory(folder)) {
+            cerr << "Error: '" << cond->name << "' folder does not exist!" << endl;
+            return 1;
+        }
+        for (const fs::path& csv : indexedFiles(folder, ".csv")) jobs.push_back({cond, csv});
+    }
+
+    vector<string> errors(jobs.size());
+    vector<string> rows = parallelMap<string>(jobs.size(), threads, [&](size_t k) {
+        return sweepSession(jobs[k].csv, *jobs[k].cond, grid, errors[k]);
+    });
+
+    ofstream out(outName);
+    if (!out) {
+        cerr << "Error: Could not open file " << outName << endl;
+        return 1;
+    }
+    out << "condition\tindex\tside\toffset\tlength\trows\tluminance\tleftPupil\tleftN\tleftSd\trightPupil\trightN\trightSd\n";
+    size_t sessions = 0;
+    for (size_t k = 0; k < jobs.size(); k++) {
+        cerr << errors[k];
+        out << rows[k];
+        if (!rows[k].empty()) sessions++;
+    }
+    cout << "Swept " << grid.size() << " windows over " << sessions << " sessions into " << outName << endl;
+    return 0;
+}